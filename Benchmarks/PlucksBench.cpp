@@ -0,0 +1,581 @@
+/*
+  ==============================================================================
+
+    PlucksBench.cpp
+
+    Microbenchmarks for the voice DSP and the note-on path.
+
+      voice_render   synth render only (PluckVoice::renderNextBlock or the
+                     voice bank), per note range, STEREO on/off, 1-36 voices
+      pitch_bend     the same with MPE notes whose bend moves every block
+      note_timer     16 voices, STEREO on/off, voices ended by the silence
+                     floor or by the old note timer
+      kernels        16 voices per string interpolation, loop coefficients
+                     settled or ramping all the time (DAMP moves every block),
+                     one specialised kernel each
+      note_on        PluckVoice::startNote on low notes, which is mostly
+                     generateExciter with delays up to ~8192 samples, or
+                     a table lookup when the exciter bank has the note
+      process_block  PlucksAudioProcessor::processBlock with dense MIDI, up to
+                     a controller burst of thousands of events per block
+      startup        constructing a processor and its first prepareToPlay,
+                     in ms (the voice arena is allocated but not touched)
+
+    Everything is reported as ns per sample per voice and written to JSON,
+    so builds with different flag sets can be diffed.
+
+      PlucksBench [--out=bench.json] [--label=name] [--quick]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "PluckVoice.h"
+
+#include <iostream>
+
+#ifndef PLUCKS_BUILD_FLAGS
+ #define PLUCKS_BUILD_FLAGS ""
+#endif
+
+#ifndef PLUCKS_BUILD_TYPE
+ #define PLUCKS_BUILD_TYPE ""
+#endif
+
+namespace
+{
+    using Engine = PluckSynth::Engine;
+
+    struct BenchSettings
+    {
+        int repeats = 5;                // best-of, after one warm-up
+        double secondsPerRun = 1.0;     // audio rendered per timed run
+    };
+
+    double ticksToNs(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9;
+    }
+
+    const char* engineName(Engine e)
+    {
+        return e == Engine::Reference ? "reference" : "bank";
+    }
+
+    void setParam(PlucksAudioProcessor& p, const juce::String& id, float value)
+    {
+        if (auto* param = p.parameters.getParameter(id))
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    std::unique_ptr<PlucksAudioProcessor> makeProcessor(double sampleRate, int blockSize, bool stereo, Engine engine)
+    {
+        auto p = std::make_unique<PlucksAudioProcessor>();
+
+        // long decay so voices don't fade to silence mid-measurement
+        setParam(*p, "DECAY", 60.0f);
+        setParam(*p, "STEREO", stereo ? 1.0f : 0.0f);
+        setParam(*p, "MAXVOICES", 36.0f);
+
+        p->setNonRealtime(true);
+        p->setPlayConfigDetails(0, 2, sampleRate, blockSize);
+        p->setRenderEngine(engine);
+        p->prepareToPlay(sampleRate, blockSize);
+
+        // one empty block pushes the parameters into the voices
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        p->processBlock(buffer, midi);
+
+        return p;
+    }
+
+    juce::var makeResult(const juce::String& bench, std::initializer_list<std::pair<const char*, juce::var>> fields)
+    {
+        auto* obj = new juce::DynamicObject();
+        obj->setProperty("bench", bench);
+
+        for (const auto& f : fields)
+            obj->setProperty(f.first, f.second);
+
+        return juce::var(obj);
+    }
+
+    //==============================================================================
+    void benchVoiceRender(const BenchSettings& settings, juce::Array<juce::var>& results)
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 64;
+        const int numBlocks = (int) (settings.secondsPerRun * sampleRate / blockSize);
+
+        struct NoteRange { const char* name; int lowest; };
+        const NoteRange ranges[] = { { "low", 24 }, { "mid", 48 }, { "high", 72 } };
+        const int voiceCounts[] = { 1, 4, 8, 16, 24, 36 };
+
+        for (auto engine : { Engine::Reference, Engine::VoiceBank })
+        for (const auto& range : ranges)
+        for (bool stereo : { false, true })
+        for (int numVoices : voiceCounts)
+        {
+            double bestNs = 0.0;
+
+            for (int run = 0; run <= settings.repeats; ++run)
+            {
+                auto p = makeProcessor(sampleRate, blockSize, stereo, engine);
+
+                for (int v = 0; v < numVoices; ++v)
+                    p->synth.noteOn(range.lowest + v, 0.8f);
+
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::MidiBuffer noMidi;
+
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                for (int b = 0; b < numBlocks; ++b)
+                {
+                    buffer.clear();
+                    p->synth.renderNextBlock(buffer, noMidi, 0, blockSize);
+                }
+
+                const double ns = ticksToNs(juce::Time::getHighResolutionTicks() - start);
+
+                if (run > 0 && (bestNs == 0.0 || ns < bestNs)) // run 0 is the warm-up
+                    bestNs = ns;
+            }
+
+            const double samples = (double) numBlocks * blockSize;
+
+            results.add(makeResult("voice_render", {
+                { "engine", engineName(engine) },
+                { "range", range.name },
+                { "stereo", stereo },
+                { "voices", numVoices },
+                { "sample_rate", sampleRate },
+                { "block_size", blockSize },
+                { "ns_per_sample", bestNs / samples },
+                { "ns_per_sample_per_voice", bestNs / (samples * numVoices) } }));
+        }
+    }
+
+    //==============================================================================
+    // The two ways a voice ends cost different things per sample: the silence floor sums
+    // the output's energy, the note timer counts down.
+    void benchNoteTimer(const BenchSettings& settings, juce::Array<juce::var>& results)
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 64;
+        const int numVoices = 16;
+        const int numBlocks = (int) (settings.secondsPerRun * sampleRate / blockSize);
+
+        for (auto engine : { Engine::Reference, Engine::VoiceBank })
+        for (bool stereo : { false, true })
+        for (bool noteTimer : { false, true })
+        {
+            double bestNs = 0.0;
+
+            for (int run = 0; run <= settings.repeats; ++run)
+            {
+                auto p = makeProcessor(sampleRate, blockSize, stereo, engine);
+                p->setNoteTimerEnabled(noteTimer);
+
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::MidiBuffer noMidi;
+                p->processBlock(buffer, noMidi); // notes started from here on use it
+
+                for (int v = 0; v < numVoices; ++v)
+                    p->synth.noteOn(48 + v, 0.8f);
+
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                for (int b = 0; b < numBlocks; ++b)
+                {
+                    buffer.clear();
+                    p->synth.renderNextBlock(buffer, noMidi, 0, blockSize);
+                }
+
+                const double ns = ticksToNs(juce::Time::getHighResolutionTicks() - start);
+
+                if (run > 0 && (bestNs == 0.0 || ns < bestNs))
+                    bestNs = ns;
+            }
+
+            const double samples = (double) numBlocks * blockSize;
+
+            results.add(makeResult("note_timer", {
+                { "engine", engineName(engine) },
+                { "stereo", stereo },
+                { "note_timer", noteTimer },
+                { "voices", numVoices },
+                { "sample_rate", sampleRate },
+                { "block_size", blockSize },
+                { "ns_per_sample_per_voice", bestNs / (samples * numVoices) } }));
+        }
+    }
+
+    //==============================================================================
+    // MPE vibrato: every note on its own channel with a new bend each block, so every
+    // string reads at a moving delay all the time. 'moving' false is the same notes held still.
+    void benchPitchBend(const BenchSettings& settings, juce::Array<juce::var>& results)
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 64;
+        const int numBlocks = (int) (settings.secondsPerRun * sampleRate / blockSize);
+
+        for (auto engine : { Engine::Reference, Engine::VoiceBank })
+        for (bool moving : { false, true })
+        for (int numVoices : { 8, 15 })
+        {
+            double bestNs = 0.0;
+
+            for (int run = 0; run <= settings.repeats; ++run)
+            {
+                auto p = makeProcessor(sampleRate, blockSize, true, engine);
+                p->synth.setMpeEnabled(true);
+
+                for (int v = 0; v < numVoices; ++v)
+                    p->synth.noteOn(48 + v, 0.8f, 0, 2 + v);
+
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::MidiBuffer noMidi;
+
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                for (int b = 0; b < numBlocks; ++b)
+                {
+                    if (moving)
+                    {
+                        // 6 Hz, a quarter tone deep
+                        const double phase = 2.0 * juce::MathConstants<double>::pi * 6.0 * b * blockSize / sampleRate;
+                        const int wheel = 8192 + (int) (std::sin(phase) * 8192.0 * 0.5 / 48.0);
+
+                        for (int v = 0; v < numVoices; ++v)
+                            p->synth.pitchWheelMoved(2 + v, wheel);
+                    }
+
+                    buffer.clear();
+                    p->synth.renderNextBlock(buffer, noMidi, 0, blockSize);
+                }
+
+                const double ns = ticksToNs(juce::Time::getHighResolutionTicks() - start);
+
+                if (run > 0 && (bestNs == 0.0 || ns < bestNs))
+                    bestNs = ns;
+            }
+
+            const double samples = (double) numBlocks * blockSize;
+
+            results.add(makeResult("pitch_bend", {
+                { "engine", engineName(engine) },
+                { "moving", moving },
+                { "voices", numVoices },
+                { "sample_rate", sampleRate },
+                { "block_size", blockSize },
+                { "ns_per_sample", bestNs / samples },
+                { "ns_per_sample_per_voice", bestNs / (samples * numVoices) } }));
+        }
+    }
+
+    //==============================================================================
+    // One row per specialised string kernel. Through processBlock, that's how a moving DAMP
+    // reaches the voices, so the numbers include its (small) per-block cost too.
+    void benchKernels(const BenchSettings& settings, juce::Array<juce::var>& results)
+    {
+        using Interpolation = PluckStringDelay::Interpolation;
+
+        const double sampleRate = 48000.0;
+        const int blockSize = 64;
+        const int numVoices = 16;
+        const int numBlocks = (int) (settings.secondsPerRun * sampleRate / blockSize);
+
+        struct Variant { const char* name; Interpolation interpolation; };
+        const Variant variants[] = { { "linear", Interpolation::Linear },
+                                     { "lagrange", Interpolation::Lagrange3rd },
+                                     { "thiran", Interpolation::Thiran } };
+
+        for (auto engine : { Engine::Reference, Engine::VoiceBank })
+        for (const auto& variant : variants)
+        for (bool ramping : { false, true })
+        {
+            double bestNs = 0.0;
+
+            for (int run = 0; run <= settings.repeats; ++run)
+            {
+                auto p = makeProcessor(sampleRate, blockSize, true, engine);
+                p->setStringInterpolation(variant.interpolation);
+
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::MidiBuffer noMidi;
+                p->processBlock(buffer, noMidi); // notes started from here on use the interpolation
+
+                for (int v = 0; v < numVoices; ++v)
+                    p->synth.noteOn(48 + v, 0.8f);
+
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                for (int b = 0; b < numBlocks; ++b)
+                {
+                    if (ramping)
+                        setParam(*p, "DAMP", (b & 1) != 0 ? 0.2f : 0.25f);
+
+                    buffer.clear();
+                    p->processBlock(buffer, noMidi);
+                }
+
+                const double ns = ticksToNs(juce::Time::getHighResolutionTicks() - start);
+
+                if (run > 0 && (bestNs == 0.0 || ns < bestNs))
+                    bestNs = ns;
+            }
+
+            const double samples = (double) numBlocks * blockSize;
+
+            results.add(makeResult("kernels", {
+                { "engine", engineName(engine) },
+                { "interpolation", variant.name },
+                { "ramping", ramping },
+                { "voices", numVoices },
+                { "sample_rate", sampleRate },
+                { "block_size", blockSize },
+                { "ns_per_sample_per_voice", bestNs / (samples * numVoices) } }));
+        }
+    }
+
+    //==============================================================================
+    void benchNoteOn(const BenchSettings& settings, juce::Array<juce::var>& results)
+    {
+        const int notesPerRun = 200;
+
+        for (bool fromExciterBank : { false, true })
+        for (double sampleRate : { 48000.0, 96000.0 })
+        for (bool stereo : { false, true })
+        for (int note : { 12, 16, 20, 24, 36 })
+        {
+            auto p = makeProcessor(sampleRate, 64, stereo, Engine::VoiceBank);
+            auto* voice = p->synth.getVoice(0);
+
+            if (fromExciterBank)
+            {
+                // the first note asks for the table, the next (non-realtime) block builds it
+                voice->startNote(note, 0.8f);
+
+                juce::AudioBuffer<float> buffer(2, 64);
+                juce::MidiBuffer midi;
+                p->processBlock(buffer, midi);
+            }
+
+            double bestNs = 0.0;
+
+            for (int run = 0; run <= settings.repeats; ++run)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                for (int i = 0; i < notesPerRun; ++i)
+                    voice->startNote(note, 0.8f);
+
+                const double ns = ticksToNs(juce::Time::getHighResolutionTicks() - start) / notesPerRun;
+
+                if (run > 0 && (bestNs == 0.0 || ns < bestNs))
+                    bestNs = ns;
+            }
+
+            voice->clearCurrentNote();
+
+            const double delaySamples = sampleRate / juce::MidiMessage::getMidiNoteInHertz(note);
+
+            results.add(makeResult("note_on", {
+                { "exciter_bank", fromExciterBank },
+                { "note", note },
+                { "stereo", stereo },
+                { "sample_rate", sampleRate },
+                { "delay_samples", delaySamples },
+                { "ns_per_note_on", bestNs },
+                { "ns_per_exciter_sample", bestNs / ((stereo ? 2.0 : 1.0) * delaySamples) } }));
+        }
+    }
+
+    //==============================================================================
+    void benchProcessBlock(const BenchSettings& settings, juce::Array<juce::var>& results)
+    {
+        const double sampleRate = 48000.0;
+        const int numBlocks = (int) (settings.secondsPerRun * sampleRate / 64);
+
+        for (auto engine : { Engine::Reference, Engine::VoiceBank })
+        for (int blockSize : { 64, 256 })
+        for (int eventsPerBlock : { 4, 32, 2048 })
+        {
+            // the same pseudo random stream of note on/offs for every build,
+            // past 32 a burst of pressure, aftertouch and mod wheel on top
+            juce::Random rng(0x5eed);
+            std::vector<juce::MidiBuffer> midi((size_t) numBlocks);
+
+            for (auto& m : midi)
+            {
+                for (int e = 0; e < juce::jmin(32, eventsPerBlock); ++e)
+                {
+                    const int note = 24 + rng.nextInt(72);
+                    const int pos = rng.nextInt(blockSize);
+
+                    if (rng.nextInt(3) == 0)
+                        m.addEvent(juce::MidiMessage::noteOff(1, note), pos);
+                    else
+                        m.addEvent(juce::MidiMessage::noteOn(1, note, 0.3f + 0.7f * rng.nextFloat()), pos);
+                }
+
+                for (int e = 32; e < eventsPerBlock; ++e)
+                {
+                    const int pos = e * blockSize / eventsPerBlock;
+                    const int value = rng.nextInt(128);
+
+                    switch (e % 3)
+                    {
+                        case 0:  m.addEvent(juce::MidiMessage::channelPressureChange(1, value), pos); break;
+                        case 1:  m.addEvent(juce::MidiMessage::aftertouchChange(1, 24 + value % 72, value), pos); break;
+                        default: m.addEvent(juce::MidiMessage::controllerEvent(1, 1, value), pos); break;
+                    }
+                }
+            }
+
+            double bestNs = 0.0;
+            double averageVoices = 0.0;
+
+            for (int run = 0; run <= settings.repeats; ++run)
+            {
+                auto p = makeProcessor(sampleRate, blockSize, true, engine);
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::int64 ticks = 0;
+                double voiceSum = 0.0;
+
+                for (int b = 0; b < numBlocks; ++b)
+                {
+                    auto block = midi[(size_t) b]; // processBlock may rewrite it
+                    buffer.clear();
+
+                    const auto start = juce::Time::getHighResolutionTicks();
+                    p->processBlock(buffer, block);
+                    ticks += juce::Time::getHighResolutionTicks() - start;
+
+                    voiceSum += p->getNumActiveVoices();
+                }
+
+                const double ns = ticksToNs(ticks);
+
+                if (run > 0 && (bestNs == 0.0 || ns < bestNs))
+                {
+                    bestNs = ns;
+                    averageVoices = voiceSum / numBlocks;
+                }
+            }
+
+            const double samples = (double) numBlocks * blockSize;
+
+            results.add(makeResult("process_block", {
+                { "engine", engineName(engine) },
+                { "block_size", blockSize },
+                { "events_per_block", eventsPerBlock },
+                { "sample_rate", sampleRate },
+                { "average_voices", averageVoices },
+                { "ns_per_sample", bestNs / samples },
+                { "ns_per_sample_per_voice", bestNs / (samples * juce::jmax(1.0, averageVoices)) } }));
+        }
+    }
+
+    //==============================================================================
+    void benchStartup(const BenchSettings& settings, juce::Array<juce::var>& results)
+    {
+        for (double sampleRate : { 48000.0, 96000.0 })
+        {
+            double bestConstructMs = 0.0, bestPrepareMs = 0.0;
+            size_t arenaBytes = 0;
+
+            for (int run = 0; run <= settings.repeats; ++run)
+            {
+                auto start = juce::Time::getHighResolutionTicks();
+                auto p = std::make_unique<PlucksAudioProcessor>();
+                const double constructMs = ticksToNs(juce::Time::getHighResolutionTicks() - start) * 1.0e-6;
+
+                p->setNonRealtime(true);
+                p->setPlayConfigDetails(0, 2, sampleRate, 512);
+
+                start = juce::Time::getHighResolutionTicks();
+                p->prepareToPlay(sampleRate, 512);
+                const double prepareMs = ticksToNs(juce::Time::getHighResolutionTicks() - start) * 1.0e-6;
+
+                arenaBytes = p->synth.getVoiceArena().getNumBytes();
+
+                if (run > 0 && (bestConstructMs == 0.0 || constructMs < bestConstructMs))
+                    bestConstructMs = constructMs;
+
+                if (run > 0 && (bestPrepareMs == 0.0 || prepareMs < bestPrepareMs))
+                    bestPrepareMs = prepareMs;
+            }
+
+            results.add(makeResult("startup", {
+                { "sample_rate", sampleRate },
+                { "construct_ms", bestConstructMs },
+                { "prepare_ms", bestPrepareMs },
+                { "arena_bytes", (juce::int64) arenaBytes } }));
+        }
+    }
+
+    void printResults(const juce::Array<juce::var>& results)
+    {
+        for (const auto& r : results)
+        {
+            juce::String line = r["bench"].toString().paddedRight(' ', 14);
+
+            if (auto* obj = r.getDynamicObject())
+                for (const auto& prop : obj->getProperties())
+                    if (prop.name.toString() != "bench")
+                        line << prop.name.toString() << "=" << prop.value.toString() << " ";
+
+            std::cout << line << std::endl;
+        }
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit; // APVTS needs a message manager
+    juce::ArgumentList args(argc, argv);
+
+    BenchSettings settings;
+
+    if (args.containsOption("--quick"))
+    {
+        settings.repeats = 1;
+        settings.secondsPerRun = 0.25;
+    }
+
+    juce::Array<juce::var> results;
+    benchVoiceRender(settings, results);
+    benchNoteTimer(settings, results);
+    benchPitchBend(settings, results);
+    benchKernels(settings, results);
+    benchNoteOn(settings, results);
+    benchProcessBlock(settings, results);
+    benchStartup(settings, results);
+
+    printResults(results);
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("label", args.containsOption("--label") ? args.getValueForOption("--label") : juce::String());
+    report->setProperty("build_type", PLUCKS_BUILD_TYPE);
+    report->setProperty("build_flags", PLUCKS_BUILD_FLAGS);
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty("simd_lanes", PluckVoiceBank::laneWidth);
+    report->setProperty("results", results);
+
+    const auto outFile = args.containsOption("--out") ? args.getFileForOption("--out")
+                                                      : juce::File::getCurrentWorkingDirectory().getChildFile("bench.json");
+
+    if (! outFile.replaceWithText(juce::JSON::toString(juce::var(report))))
+    {
+        std::cerr << "can't write " << outFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << "wrote " << outFile.getFullPathName() << std::endl;
+    return 0;
+}
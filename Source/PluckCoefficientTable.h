@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    PluckCoefficientTable.h
+
+    The string loop's coefficients for every note, worked out once per
+    parameter change instead of once per voice. The processor updates it at
+    the top of the block, and voices read what they need when a note
+    starts or a parameter moves.
+
+      feedback      per note, from DECAY and the note's period (tuning and
+                    sample rate, not fine tune)
+      note timer    per note, from DECAY and DAMP, for the legacy timer
+      damping       one value from DAMP
+      curve         one value from DAMPINGCURVE
+
+    Each column is only rebuilt when something it depends on moved, so
+    automating DAMP doesn't redo 128 pows for the feedback. None of it
+    depends on how many voices are playing.
+
+    The formulas live here as static functions too. A voice without a table
+    (the equivalence rigs, a bare PluckSynth) calls those directly and gets
+    the same numbers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluckParameters.h"
+#include "PluckVoiceBank.h"
+#include "PluckExciterBank.h"
+#include "TuningSystem.h"
+
+class PluckCoefficientTable
+{
+public:
+    static constexpr int numNotes = 128;
+
+    //==============================================================================
+    static float computeFeedbackGain(float decay, float cyclesPerSecond) noexcept
+    {
+        const float targetAmplitude = 0.001f;
+
+        // 1.5f multiplier is used to try and match the expected decay time at a reasonable note range
+        float feedbackGain = std::pow(targetAmplitude, 1.0f / (1.5f * decay * cyclesPerSecond));
+        return juce::jlimit(0.0f, 0.999f, feedbackGain);
+    }
+
+    // The note's frequency the feedback is worked out from: the tuning's period alone.
+    // Fine tune and microtune glide a playing note's delay but leave its decay be, so
+    // automating them never touches the feedback column.
+    static float getCyclesPerSecond(const TuningSystem* tuning, int note, double sampleRate) noexcept
+    {
+        float period, unused;
+        PluckExciterBank::computeDelays(tuning, note, sampleRate, 1.0f, 1.0f, period, unused);
+        return (float) (sampleRate / period);
+    }
+
+    static float computeDamping(float damp) noexcept
+    {
+        return juce::jmap(damp, 0.0f, 1.0f, 0.99f, 0.01f);
+    }
+
+    // The old pitch based note length: low notes ring up to 60x longer than high ones
+    static float getNoteTimerFactor(int note) noexcept
+    {
+        const float minNote = 24.0f;
+        const float maxNote = 108.0f;
+        const float ratio = 60.0f;
+        const float clampedNote = juce::jlimit(minNote, maxNote, static_cast<float>(note));
+
+        return std::pow(ratio, (maxNote - clampedNote) / (maxNote - minNote));
+    }
+
+    static int computeNoteTimerSamples(float noteTimerFactor, float decay, float damp, double sampleRate) noexcept
+    {
+        const float baseDecayTime = juce::jlimit(0.05f, 60.0f, decay);
+        const float normalizedDamp = juce::jmap(damp, 0.0f, 0.65f, 0.0f, 1.0f);
+        const float dampMultiplier = juce::jmap(normalizedDamp, 0.0f, 1.0f, 1.0f, 0.5f);
+        const float totalDecayTime = baseDecayTime * dampMultiplier * noteTimerFactor * 0.25f;
+
+        return static_cast<int>(sampleRate * totalDecayTime);
+    }
+
+    //==============================================================================
+    PluckCoefficientTable()
+    {
+        for (int note = 0; note < numNotes; ++note)
+            noteTimerFactors[(size_t) note] = getNoteTimerFactor(note);
+    }
+
+    // Audio thread, top of the block, before any voice reads. Rebuilds whatever the
+    // parameters, the sample rate or the tuning moved since the last call.
+    void update(const PluckParameters& p, double sampleRate, const TuningSystem* tuning) noexcept
+    {
+        if (sampleRate <= 0.0)
+            return;
+
+        const auto tuningVersion = tuning != nullptr ? tuning->getVersion() : 0;
+
+        if (! built || p.decay != decay || sampleRate != rate || tuning != tuningSystem || tuningVersion != builtTuningVersion)
+        {
+            // the same cycles a voice starting this note works out
+            for (int note = 0; note < numNotes; ++note)
+                feedbackGains[(size_t) note] = computeFeedbackGain(p.decay, getCyclesPerSecond(tuning, note, sampleRate));
+
+            tuningSystem = tuning;
+            builtTuningVersion = tuningVersion;
+        }
+
+        if (! built || p.decay != decay || p.damp != damp || sampleRate != rate)
+            for (int note = 0; note < numNotes; ++note)
+                noteTimerSamples[(size_t) note] = computeNoteTimerSamples(noteTimerFactors[(size_t) note], p.decay, p.damp, sampleRate);
+
+        if (! built || p.damp != damp)
+            damping = computeDamping(p.damp);
+
+        if (! built || p.dampingCurve != dampingCurve)
+            curveAmount = PluckVoiceBank::getCurveAmount(p.dampingCurve);
+
+        decay = p.decay;
+        damp = p.damp;
+        dampingCurve = p.dampingCurve;
+        rate = sampleRate;
+        built = true;
+    }
+
+    bool isBuilt() const noexcept { return built; }
+
+    float getFeedbackGain(int note) const noexcept   { return feedbackGains[(size_t) juce::jlimit(0, numNotes - 1, note)]; }
+    int getNoteTimerSamples(int note) const noexcept { return noteTimerSamples[(size_t) juce::jlimit(0, numNotes - 1, note)]; }
+    float getDamping() const noexcept                { return damping; }
+    float getCurveAmount() const noexcept            { return curveAmount; }
+
+private:
+    std::array<float, numNotes> feedbackGains {};
+    std::array<int, numNotes> noteTimerSamples {};
+    std::array<float, numNotes> noteTimerFactors {};
+    float damping = 0.0f;
+    float curveAmount = 0.0f;
+
+    // what the columns were built from
+    bool built = false;
+    float decay = 0.0f, damp = 0.0f, dampingCurve = 0.0f;
+    double rate = 0.0;
+    const TuningSystem* tuningSystem = nullptr;
+    juce::uint32 builtTuningVersion = 0;
+};
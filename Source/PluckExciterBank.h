@@ -0,0 +1,514 @@
+/*
+  ==============================================================================
+
+    PluckExciterBank.h
+
+    Precomputed exciters, shared by all voices of a plugin instance.
+
+    A background thread renders exciter tables for every note that has been
+    played, per velocity bucket, for the current COLOR / EXCITERSLEWRATE /
+    tuning / sample rate. A note start then only grabs a pointer instead of
+    running the exciter loop on the audio thread. When the parameters move,
+    a new generation gets built next to the old one and swapped in. Voices
+    that still read the old one keep it alive until they let go.
+
+    Nothing here allocates or locks on the audio thread. A lookup that misses
+    (table not built yet, parameters just changed) returns false, and the
+    voice renders the same table into its own buffer with renderExciter(),
+    so a pluck sounds the same whether it hit or missed.
+
+    In non-realtime mode, with the builder thread stopped, the tables are
+    built at the top of the block on the audio thread, so offline renders
+    stay repeatable.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TuningSystem.h"
+#include "PluckNoise.h"
+
+class PluckExciterBank
+{
+public:
+    static constexpr int maxDelaySamples = 8192;    // same as PluckVoice::maxBufferSize
+    static constexpr int numVelocityBuckets = 8;
+    static constexpr int numVariants = 4;           // a few noise takes per note so repeats don't sound stamped
+    static constexpr int numNotes = 128;
+
+    // everything a table depends on
+    struct Config
+    {
+        double sampleRate = 0.0;
+        float delayScaleL = 1.0f;       // fine tune and microtune, see PluckParameters
+        float delayScaleR = 1.0f;
+        float color = 0.5f;
+        float exciterSlewRate = 1.0f;
+        bool stereo = true;
+        juce::uint32 noiseSeed = 0;
+        juce::uint32 tuningVersion = 0;
+
+        // every note's period at sampleRate (TuningSystem::getPeriods), the builder
+        // never reads the TuningSystem itself. Follows tuningVersion, so not compared.
+        std::array<float, numNotes> periods {};
+
+        bool operator== (const Config& o) const noexcept
+        {
+            return sampleRate == o.sampleRate && delayScaleL == o.delayScaleL
+                && delayScaleR == o.delayScaleR && color == o.color
+                && exciterSlewRate == o.exciterSlewRate && stereo == o.stereo && noiseSeed == o.noiseSeed
+                && tuningVersion == o.tuningVersion;
+        }
+
+        bool operator!= (const Config& o) const noexcept { return ! operator== (o); }
+    };
+
+    // what a voice is about to play
+    struct Request
+    {
+        int note = -1;
+        float delayL = 0.0f;            // exact delays the voice computed
+        float delayR = 0.0f;
+        float velocity = 1.0f;
+        float color = 0.5f;
+        float exciterSlewRate = 1.0f;
+        bool stereo = true;
+        juce::uint32 noiseSeed = 0;
+        int variant = 0;
+    };
+
+    // a table a voice is reading from, hand back with release()
+    struct Lease
+    {
+        const float* left = nullptr;
+        const float* right = nullptr;
+        int lengthL = 0;                // readable samples, zero padded past the delay
+        int lengthR = 0;
+        int slot = -1;
+    };
+
+    PluckExciterBank() : builder(*this) {}
+
+    ~PluckExciterBank()
+    {
+        stopBackgroundBuilds();
+    }
+
+    // Realtime: a background thread builds. Non-realtime: stop it, and update() builds in place.
+    void startBackgroundBuilds()
+    {
+        if (! builder.isThreadRunning())
+            builder.startThread(juce::Thread::Priority::low);
+    }
+
+    void stopBackgroundBuilds()
+    {
+        builder.stopThread(1000);
+    }
+
+    //==============================================================================
+    // Audio thread, top of every block: asks for a rebuild when the config moved,
+    // swaps in finished generations and recycles old ones nobody reads anymore.
+    // buildNow only builds while the builder thread is stopped, the two never build at once.
+    void update(const Config& config, bool buildNow)
+    {
+        if (config != requestedConfig)
+        {
+            requestedConfig = config;
+            publishConfig(config);
+        }
+
+        if (buildNow && ! builder.isThreadRunning())
+            buildIfNeeded();
+
+        int newest = -1;
+        for (int s = 0; s < numSlots; ++s)
+            if (slots[s].state.load(std::memory_order_acquire) == slotReady
+                 && (newest < 0 || slots[s].serial > slots[newest].serial))
+                newest = s;
+
+        if (newest >= 0)
+        {
+            // anything else that finished in the meantime is already out of date
+            for (int s = 0; s < numSlots; ++s)
+                if (s != newest && slots[s].state.load(std::memory_order_acquire) == slotReady)
+                    slots[s].state.store(slotRetired, std::memory_order_release);
+
+            if (activeSlot >= 0)
+                slots[activeSlot].state.store(slotRetired, std::memory_order_release);
+
+            activeSlot = newest;
+            slots[activeSlot].state.store(slotActive, std::memory_order_release);
+        }
+
+        for (auto& slot : slots)
+            if (slot.users.load(std::memory_order_acquire) == 0 && slot.state.load(std::memory_order_acquire) == slotRetired)
+                slot.state.store(slotFree, std::memory_order_release);
+    }
+
+    // Audio thread or a render pool worker mid-block (re-excites). True if the active
+    // generation has an exact match for this note.
+    bool acquire(const Request& r, Lease& lease)
+    {
+        if (! juce::isPositiveAndBelow(r.note, numNotes))
+            return false;
+
+        if (activeSlot < 0)
+        {
+            markWanted(r.note);
+            return false;
+        }
+
+        auto& slot = slots[activeSlot];
+        const auto& entry = slot.notes[(size_t) r.note];
+
+        if (! entry.built)
+        {
+            markWanted(r.note);
+            return false;
+        }
+
+        if (slot.config.color != r.color || slot.config.exciterSlewRate != r.exciterSlewRate
+             || slot.config.stereo != r.stereo || slot.config.noiseSeed != r.noiseSeed)
+            return false; // update() already asked for these
+
+        // the delays are the real key, anything that moved them (tuning mid-swap, a torn
+        // config read on the builder side) just means this table isn't ours
+        if (entry.delayL != r.delayL || entry.delayR != r.delayR)
+            return false;
+
+        const int bucket = getVelocityBucket(r.velocity);
+        const int variant = juce::jlimit(0, numVariants - 1, r.variant);
+
+        lease.left = slot.data.data() + entry.offset[bucket][variant][0];
+        lease.right = slot.data.data() + entry.offset[bucket][variant][1];
+        lease.lengthL = entry.lengthL;
+        lease.lengthR = entry.lengthR;
+        lease.slot = activeSlot;
+
+        slot.users.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void release(Lease& lease)
+    {
+        if (lease.slot >= 0)
+        {
+            jassert(slots[lease.slot].users.load(std::memory_order_relaxed) > 0);
+            slots[lease.slot].users.fetch_sub(1, std::memory_order_release);
+        }
+
+        lease = {};
+    }
+
+    //==============================================================================
+    // Same delay math as PluckVoice::setDelayTimes, shared so the exact match holds:
+    // the tuning's period for the note times the fine tune / microtune scales.
+    static void computeDelays(const TuningSystem* tuning, int note, double sampleRate, float delayScaleL, float delayScaleR,
+                              float& delayL, float& delayR)
+    {
+        const float period = tuning != nullptr ? tuning->getPeriodInSamples(note, sampleRate)
+                                               : (float) (sampleRate / juce::MidiMessage::getMidiNoteInHertz(note));
+
+        computeDelays(period, delayScaleL, delayScaleR, delayL, delayR);
+    }
+
+    static void computeDelays(float period, float delayScaleL, float delayScaleR, float& delayL, float& delayR)
+    {
+        delayL = period * delayScaleL;
+        delayR = period * delayScaleR;
+    }
+
+    static float getPulseWidth(float velocity)
+    {
+        return 2 * juce::jlimit(0.01f, 1.0f, (velocity - minimumExciterVelocity) / (1.0f - minimumExciterVelocity));
+    }
+
+    // anything at or above a pulse width of 1 sounds the same, so the top bucket covers it
+    static int getVelocityBucket(float velocity)
+    {
+        const float width = getPulseWidth(velocity);
+        return juce::jlimit(0, numVelocityBuckets - 1, (int) std::ceil(width * numVelocityBuckets) - 1);
+    }
+
+    // the pulse width a bucket's tables are rendered with
+    static float getBucketPulseWidth(int bucket)
+    {
+        return (float) (bucket + 1) / numVelocityBuckets;
+    }
+
+    // samples of exciter for a delay, the rest of the table is zeros
+    static int getSafeLength(float delay)
+    {
+        return juce::jlimit(1, maxDelaySamples - 1, static_cast<int>(std::round(delay)));
+    }
+
+    // One table: the bucket's pulse width, and noise keyed by note, bucket, take and channel
+    // so the content doesn't depend on what else got built. The builder renders every table
+    // through here, and so does a voice that missed, into its own buffer.
+    static void renderExciter(float* dest, int length, float delay, int note, int bucket, int variant, int channel,
+                              juce::uint32 noiseSeed, float color, float slewRate)
+    {
+        PluckNoise noise;
+        noise.setKey(noiseSeed, (juce::uint32) (((note * numVelocityBuckets + bucket) * numVariants + variant) * 2 + channel));
+        noise.fillBipolar(dest, length);
+
+        float prevNoise = 0.0f;
+        shapeExciter(dest, length, delay, getBucketPulseWidth(bucket), color, slewRate, prevNoise);
+    }
+
+    // A take other than the last one, 'random' in [-1, 1), so a repeated note never
+    // plays the same burst twice in a row
+    static int nextVariant(int previous, float random)
+    {
+        const int step = 1 + juce::jlimit(0, numVariants - 2, (int) ((random + 1.0f) * 0.5f * (float) (numVariants - 1)));
+        return (juce::jmax(0, previous) + step) % numVariants;
+    }
+
+    // The exciter shape: pulse width limited square, crossfaded by COLOR into slew
+    // limited noise. 'dest' holds the raw noise on the way in and the exciter on the way out.
+    static void shapeExciter(float* dest, int length, float delayFrac, float pulseWidth,
+                             float color, float slewRate, float& prevNoise)
+    {
+        const float halfPeriod = delayFrac * 0.5f;
+
+        for (int i = 0; i < length; ++i)
+        {
+            float squareSample = (i < halfPeriod) ?
+                (((float)i / halfPeriod < pulseWidth) ? plainSquareAmp : 0.0f)
+                : ((((float)(i - halfPeriod) / halfPeriod) < pulseWidth) ? -plainSquareAmp : 0.0f);
+
+            float noiseSample = ((float)i / length < pulseWidth) ? dest[i] : 0.0f;
+
+            // note: even with slew rate set to 1.0f, there was some artifacts from that so set up a conditional
+            float slewedNoise;
+            if (slewRate >= 1.0f)
+            {
+                slewedNoise = noiseSample;
+            }
+            else
+            {
+                float alpha = juce::jlimit(0.0f, 1.0f, slewRate);
+                slewedNoise = alpha * noiseSample + (1.0f - alpha) * prevNoise;
+                prevNoise = slewedNoise;
+            }
+
+            dest[i] = juce::jmap(color, squareSample, slewedNoise);
+        }
+    }
+
+    static constexpr float plainSquareAmp = 0.43f;
+    static constexpr float minimumExciterVelocity = 0.1f;
+
+private:
+    enum SlotState
+    {
+        slotFree,       // builder may take it
+        slotBuilding,   // builder owns it
+        slotReady,      // built, waiting for the audio thread
+        slotActive,     // what acquire() hands out
+        slotRetired     // replaced, freed once users drops to 0
+    };
+
+    struct NoteEntry
+    {
+        bool built = false;
+        float delayL = 0.0f, delayR = 0.0f;
+        int lengthL = 0, lengthR = 0;
+        int offset[numVelocityBuckets][numVariants][2] = {};
+    };
+
+    struct Slot
+    {
+        std::atomic<int> state { slotFree };
+        juce::uint32 serial = 0;
+        Config config;
+        std::array<NoteEntry, numNotes> notes;
+        std::vector<float> data;
+
+        std::atomic<int> users { 0 };   // audio thread and render pool workers
+    };
+
+    class Builder : public juce::Thread
+    {
+    public:
+        explicit Builder(PluckExciterBank& b) : juce::Thread("Plucks exciter bank"), bank(b) {}
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                bank.buildIfNeeded();
+                wait(20);
+            }
+        }
+
+    private:
+        PluckExciterBank& bank;
+    };
+
+    //==============================================================================
+    void publishConfig(const Config& c)
+    {
+        pendingSampleRate.store(c.sampleRate, std::memory_order_relaxed);
+        pendingScaleL.store(c.delayScaleL, std::memory_order_relaxed);
+        pendingScaleR.store(c.delayScaleR, std::memory_order_relaxed);
+        pendingColor.store(c.color, std::memory_order_relaxed);
+        pendingSlewRate.store(c.exciterSlewRate, std::memory_order_relaxed);
+        pendingStereo.store(c.stereo, std::memory_order_relaxed);
+        pendingSeed.store(c.noiseSeed, std::memory_order_relaxed);
+        pendingTuningVersion.store(c.tuningVersion, std::memory_order_relaxed);
+
+        for (int note = 0; note < numNotes; ++note)
+            pendingPeriods[(size_t) note].store(c.periods[(size_t) note], std::memory_order_relaxed);
+
+        requestSerial.fetch_add(1, std::memory_order_release);
+    }
+
+    Config loadPublishedConfig() const
+    {
+        Config c;
+        c.sampleRate = pendingSampleRate.load(std::memory_order_relaxed);
+        c.delayScaleL = pendingScaleL.load(std::memory_order_relaxed);
+        c.delayScaleR = pendingScaleR.load(std::memory_order_relaxed);
+        c.color = pendingColor.load(std::memory_order_relaxed);
+        c.exciterSlewRate = pendingSlewRate.load(std::memory_order_relaxed);
+        c.stereo = pendingStereo.load(std::memory_order_relaxed);
+        c.noiseSeed = pendingSeed.load(std::memory_order_relaxed);
+        c.tuningVersion = pendingTuningVersion.load(std::memory_order_relaxed);
+
+        for (int note = 0; note < numNotes; ++note)
+            c.periods[(size_t) note] = pendingPeriods[(size_t) note].load(std::memory_order_relaxed);
+
+        return c;
+    }
+
+    void markWanted(int note)
+    {
+        wantedNotes[note >> 6].fetch_or((juce::uint64) 1 << (note & 63), std::memory_order_release);
+    }
+
+    // Builder thread, or the audio thread while the builder is stopped, never both. A torn config read
+    // just builds a table nobody matches, and the request that follows fixes it.
+    void buildIfNeeded()
+    {
+        const auto serial = requestSerial.load(std::memory_order_acquire);
+        const juce::uint64 wanted[2] = { wantedNotes[0].load(std::memory_order_acquire),
+                                         wantedNotes[1].load(std::memory_order_acquire) };
+
+        if (serial == builtSerial && (wanted[0] & ~builtNotes[0]) == 0 && (wanted[1] & ~builtNotes[1]) == 0)
+            return;
+
+        const Config config = loadPublishedConfig();
+        if (config.sampleRate <= 0.0)
+            return;
+
+        Slot* slot = nullptr;
+        for (auto& s : slots)
+        {
+            if (s.state.load(std::memory_order_acquire) == slotFree)
+            {
+                slot = &s;
+                break;
+            }
+        }
+
+        if (slot == nullptr)
+            return; // everything is in use, try again later
+
+        slot->state.store(slotBuilding, std::memory_order_relaxed);
+        buildSlot(*slot, config, wanted);
+        slot->serial = ++buildCounter;
+        slot->state.store(slotReady, std::memory_order_release);
+
+        builtSerial = serial;
+        builtNotes[0] = wanted[0];
+        builtNotes[1] = wanted[1];
+    }
+
+    void buildSlot(Slot& slot, const Config& config, const juce::uint64 wanted[2])
+    {
+        slot.config = config;
+
+        // lay the tables out first so the data vector is sized once
+        int total = 0;
+        for (int note = 0; note < numNotes; ++note)
+        {
+            auto& entry = slot.notes[(size_t) note];
+            entry.built = (wanted[note >> 6] >> (note & 63)) & 1;
+
+            if (! entry.built)
+                continue;
+
+            computeDelays(config.periods[(size_t) note], config.delayScaleL, config.delayScaleR,
+                          entry.delayL, entry.delayR);
+
+            // voices inject for ceil(delay) samples, pad so the tail reads zeros
+            entry.lengthL = getSafeLength(entry.delayL) + 2;
+            entry.lengthR = getSafeLength(entry.delayR) + 2;
+
+            for (int b = 0; b < numVelocityBuckets; ++b)
+                for (int v = 0; v < numVariants; ++v)
+                {
+                    entry.offset[b][v][0] = total;
+                    total += entry.lengthL;
+
+                    if (config.stereo)
+                    {
+                        entry.offset[b][v][1] = total;
+                        total += entry.lengthR;
+                    }
+                    else
+                    {
+                        entry.offset[b][v][1] = entry.offset[b][v][0]; // mono shares the left table
+                    }
+                }
+        }
+
+        slot.data.assign((size_t) total, 0.0f);
+
+        for (int note = 0; note < numNotes; ++note)
+        {
+            const auto& entry = slot.notes[(size_t) note];
+            if (! entry.built)
+                continue;
+
+            for (int b = 0; b < numVelocityBuckets; ++b)
+                for (int v = 0; v < numVariants; ++v)
+                    for (int ch = 0; ch < (config.stereo ? 2 : 1); ++ch)
+                    {
+                        const float delay = ch == 0 ? entry.delayL : entry.delayR;
+
+                        renderExciter(slot.data.data() + entry.offset[b][v][ch], getSafeLength(delay), delay,
+                                      note, b, v, ch, config.noiseSeed, config.color, config.exciterSlewRate);
+                    }
+        }
+    }
+
+    //==============================================================================
+    static constexpr int numSlots = 4;
+    std::array<Slot, numSlots> slots;
+    int activeSlot = -1;                        // audio thread only
+    Config requestedConfig;                     // audio thread only
+
+    // audio thread -> builder
+    std::atomic<juce::uint32> requestSerial { 0 };
+    std::atomic<juce::uint64> wantedNotes[2] { { 0 }, { 0 } };
+    std::atomic<double> pendingSampleRate { 0.0 };
+    std::atomic<float> pendingScaleL { 1.0f }, pendingScaleR { 1.0f };
+    std::atomic<float> pendingColor { 0.5f }, pendingSlewRate { 1.0f };
+    std::atomic<bool> pendingStereo { true };
+    std::atomic<juce::uint32> pendingSeed { 0 }, pendingTuningVersion { 0 };
+    std::array<std::atomic<float>, numNotes> pendingPeriods {};
+
+    // builder only
+    juce::uint32 builtSerial = 0;
+    juce::uint64 builtNotes[2] = { 0, 0 };
+    juce::uint32 buildCounter = 0;
+
+    Builder builder;
+
+    JUCE_DECLARE_NON_COPYABLE(PluckExciterBank)
+};
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    PluckImageCache.h
+
+    The GUI's PNGs, resampled once for the size and display scale they are
+    drawn at instead of on every paint. Entries are keyed by the source
+    image, the target size in physical pixels and (for the knob) the
+    rotation step, so a window moving to a retina screen or a resized
+    editor just makes new entries.
+
+    The knob is a lazy filmstrip: framesPerTurn pre-rotated frames around a
+    full turn, each rendered the first time the knob lands on it.
+
+    The PNGs themselves are decoded here too, from BinaryData on first use
+    rather than when an editor is built, so a page nobody opens never
+    decodes its images.
+
+    Every editor gets the same cache through juce::SharedResourcePointer,
+    so a session with many Plucks windows open decodes and scales each
+    image once. Message thread only.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PluckImageCache
+{
+public:
+    // knob filmstrip resolution, frames per full turn
+    static constexpr int framesPerTurn = 256;
+
+    // Draws source over area, from a copy scaled to the pixels area covers on screen.
+    void drawScaled(juce::Graphics& g, const juce::Image& source, juce::Rectangle<float> area)
+    {
+        drawCached(g, get(source, getPixelSize(g, area), -1), area);
+    }
+
+    // The same, turned by angle (radians) around the centre of area, rounded to the nearest frame.
+    void drawRotated(juce::Graphics& g, const juce::Image& source, juce::Rectangle<float> area, float angle)
+    {
+        const int step = juce::roundToInt(angle / juce::MathConstants<float>::twoPi * (float) framesPerTurn);
+        const int frame = ((step % framesPerTurn) + framesPerTurn) % framesPerTurn;
+
+        drawCached(g, get(source, getPixelSize(g, area), frame), area);
+    }
+
+    // An embedded PNG (or any format JUCE reads), decoded the first time it's asked for.
+    juce::Image getEmbedded(const void* data, int numBytes)
+    {
+        const auto found = decoded.find(data);
+        if (found != decoded.end())
+            return found->second;
+
+        // a bad image stays invalid instead of being decoded again on every paint
+        return decoded[data] = juce::ImageFileFormat::loadFrom(data, (size_t) numBytes);
+    }
+
+private:
+    using Key = std::tuple<const void*, int, int, int>;
+
+    // keeps a runaway (e.g. endless window resizing) from holding on to every size it saw
+    static constexpr size_t maxEntries = 1024;
+
+    static juce::Point<int> getPixelSize(juce::Graphics& g, juce::Rectangle<float> area)
+    {
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        return { juce::jmax(1, juce::roundToInt(area.getWidth() * scale)),
+                 juce::jmax(1, juce::roundToInt(area.getHeight() * scale)) };
+    }
+
+    static void drawCached(juce::Graphics& g, const juce::Image& image, juce::Rectangle<float> area)
+    {
+        if (! image.isValid())
+            return;
+
+        // image pixels map 1:1 onto the screen, the renderer can blit instead of resampling
+        g.drawImageTransformed(image, juce::AffineTransform::scale(area.getWidth() / (float) image.getWidth(),
+                                                                   area.getHeight() / (float) image.getHeight())
+                                          .translated(area.getX(), area.getY()));
+    }
+
+    juce::Image get(const juce::Image& source, juce::Point<int> size, int frame)
+    {
+        if (! source.isValid())
+            return {};
+
+        const void* pixels = source.getPixelData();
+        const Key key { pixels, size.x, size.y, frame };
+
+        const auto found = images.find(key);
+        if (found != images.end())
+            return found->second.image;
+
+        auto image = frame < 0 ? scale(source, size) : rotate(get(source, size, -1), frame);
+
+        if (images.size() >= maxEntries)
+            images.clear();
+
+        images[key] = { source, image };
+        return image;
+    }
+
+    static juce::Image scale(const juce::Image& source, juce::Point<int> size)
+    {
+        if (source.getWidth() == size.x && source.getHeight() == size.y)
+            return source;
+
+        return source.rescaled(size.x, size.y, juce::Graphics::highResamplingQuality);
+    }
+
+    static juce::Image rotate(const juce::Image& scaled, int frame)
+    {
+        juce::Image rotated(juce::Image::ARGB, scaled.getWidth(), scaled.getHeight(), true);
+        juce::Graphics g(rotated);
+        g.setImageResamplingQuality(juce::Graphics::highResamplingQuality);
+
+        const float angle = juce::MathConstants<float>::twoPi * (float) frame / (float) framesPerTurn;
+        g.drawImageTransformed(scaled, juce::AffineTransform::rotation(angle, (float) scaled.getWidth() * 0.5f,
+                                                                              (float) scaled.getHeight() * 0.5f));
+        return rotated;
+    }
+
+    struct Entry
+    {
+        juce::Image source;     // holds on to the pixel data the key points at
+        juce::Image image;
+    };
+
+    std::map<Key, Entry> images;
+    std::map<const void*, juce::Image> decoded;
+};
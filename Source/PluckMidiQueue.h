@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    PluckMidiQueue.h
+
+    The block's MIDI, decoded once into a fixed array the synth walks
+    directly. Replaces the juce::MidiBuffer processBlock used to rebuild
+    (and grow, on the heap) every block.
+
+    Events are decoded from the raw bytes, so no juce::MidiMessage gets
+    built, and only what PluckSynth acts on is kept: notes, pitch wheel,
+    pressure, aftertouch, sustain and the all-notes-off / reset
+    controllers, plus program changes for the processor. Everything else
+    (other CCs, clock, sysex) is dropped here instead of being copied
+    through.
+
+    The capacity is fixed at construction. Past the last few slots
+    (reservedSlots) a pitch wheel, pressure or aftertouch event replaces
+    the one before it if that was the same stream, so a dense controller
+    burst can't push note-offs out. Anything that still doesn't fit is
+    counted, see takeNumDropped().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PluckMidiQueue
+{
+public:
+    enum class Type : juce::uint8
+    {
+        none = 0,
+        noteOn,
+        noteOff,
+        pitchWheel,             // value 0..16383, 8192 = centre
+        channelPressure,
+        aftertouch,
+        sustainPedal,           // value 0 / 1
+        allNotesOff,            // all notes off and all sound off
+        resetAllControllers,
+        programChange           // value = program, the processor takes these out
+    };
+
+    struct Event
+    {
+        int samplePosition = 0;
+        Type type = Type::none;
+        juce::uint8 channel = 1;        // 1..16, like juce::MidiMessage::getChannel()
+        juce::uint8 note = 0;
+        juce::uint16 value = 0;         // velocity, pressure or wheel position
+
+        // same scaling as juce::MidiMessage::getFloatVelocity()
+        float getFloatVelocity() const noexcept { return value * (1.0f / 127.0f); }
+
+        bool isContinuous() const noexcept
+        {
+            return type == Type::pitchWheel || type == Type::channelPressure || type == Type::aftertouch;
+        }
+
+        bool isSameStream(const Event& other) const noexcept
+        {
+            return type == other.type && channel == other.channel && (type != Type::aftertouch || note == other.note);
+        }
+    };
+
+    static constexpr int defaultCapacity = 8192;
+    static constexpr int reservedSlots = 256;
+
+    // Allocates here, never afterwards.
+    explicit PluckMidiQueue(int capacityToUse = defaultCapacity)
+        : events((size_t) juce::jmax(reservedSlots + 1, capacityToUse))
+    {
+    }
+
+    //==============================================================================
+    // Type::none for anything the synth doesn't act on.
+    static Event decode(const juce::uint8* data, int numBytes, int samplePosition) noexcept
+    {
+        Event e;
+        e.samplePosition = samplePosition;
+
+        if (data == nullptr || numBytes < 1 || data[0] < 0x80 || data[0] >= 0xf0)
+            return e;
+
+        const int status = data[0] & 0xf0;
+        const int data1 = numBytes > 1 ? data[1] & 0x7f : 0;
+        const int data2 = numBytes > 2 ? data[2] & 0x7f : 0;
+
+        e.channel = (juce::uint8) ((data[0] & 0x0f) + 1);
+        e.note = (juce::uint8) data1;
+        e.value = (juce::uint16) data2;
+
+        switch (status)
+        {
+            case 0x90:  e.type = data2 > 0 ? Type::noteOn : Type::noteOff; break;
+            case 0x80:  e.type = Type::noteOff; break;
+            case 0xa0:  e.type = Type::aftertouch; break;
+            case 0xc0:  e.type = Type::programChange; e.value = (juce::uint16) data1; break;
+            case 0xd0:  e.type = Type::channelPressure; e.value = (juce::uint16) data1; break;
+            case 0xe0:  e.type = Type::pitchWheel; e.value = (juce::uint16) (data1 | (data2 << 7)); break;
+
+            case 0xb0:
+                if (data1 == 64)                    { e.type = Type::sustainPedal; e.value = data2 >= 64 ? 1 : 0; }
+                else if (data1 == 120 || data1 == 123) e.type = Type::allNotesOff;
+                else if (data1 == 121)              e.type = Type::resetAllControllers;
+                break;
+
+            default:
+                break;
+        }
+
+        return e;
+    }
+
+    void clear() noexcept { size = 0; }
+
+    // false if the event was dropped (or is one the synth ignores)
+    bool add(const Event& e) noexcept
+    {
+        if (e.type == Type::none)
+            return false;
+
+        const bool crowded = e.isContinuous() ? size >= getCapacity() - reservedSlots : size >= getCapacity();
+
+        if (crowded)
+        {
+            if (e.isContinuous() && size > 0 && events[(size_t) size - 1].isSameStream(e))
+            {
+                events[(size_t) size - 1] = e;
+                return true;
+            }
+
+            ++dropped;
+            return false;
+        }
+
+        events[(size_t) size++] = e;
+        return true;
+    }
+
+    bool add(const juce::MidiMessageMetadata& metadata) noexcept
+    {
+        return add(decode(metadata.data, metadata.numBytes, metadata.samplePosition));
+    }
+
+    // Everything in a juce::MidiBuffer, for callers that still have one
+    void addAll(const juce::MidiBuffer& midi) noexcept
+    {
+        for (const auto metadata : midi)
+            add(metadata);
+    }
+
+    int getNumEvents() const noexcept { return size; }
+    int getCapacity() const noexcept { return (int) events.size(); }
+    bool isEmpty() const noexcept { return size == 0; }
+
+    const Event& operator[](int index) const noexcept { return events[(size_t) index]; }
+    const Event* begin() const noexcept { return events.data(); }
+    const Event* end() const noexcept { return events.data() + size; }
+
+    // events that didn't fit since the last call, for PluckTelemetry
+    juce::uint32 takeNumDropped() noexcept
+    {
+        const auto count = dropped;
+        dropped = 0;
+        return count;
+    }
+
+private:
+    std::vector<Event> events;
+    int size = 0;
+    juce::uint32 dropped = 0;
+};
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    PluckNoise.h
+
+    Counter-based noise for the exciters. Every sample is a pure hash of
+    (key, position), so each voice owns its own stream, a span fills with
+    no loop-carried state (the loop vectorizes) and the same seed always
+    gives the same exciters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PluckNoise
+{
+public:
+    // seed is shared by all voices, stream tells the voices apart
+    void setKey(juce::uint32 seed, juce::uint32 stream) noexcept
+    {
+        keyA = mix(seed + 0x9e3779b9u);
+        keyB = mix(keyA ^ (stream * 0x85ebca6bu + 0xc2b2ae35u));
+        counter = 0;
+    }
+
+    void reset() noexcept { counter = 0; }
+
+    // uniform in [-1, 1), same distribution as Random::nextFloat() * 2 - 1
+    void fillBipolar(float* dest, int numSamples) noexcept
+    {
+        const juce::uint32 a = keyA;
+        const juce::uint32 b = keyB;
+        const juce::uint32 start = counter;
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = toBipolar(mix(mix(start + (juce::uint32) i + a) ^ b));
+
+        counter += (juce::uint32) numSamples;
+    }
+
+    float nextBipolar() noexcept
+    {
+        return toBipolar(mix(mix(counter++ + keyA) ^ keyB));
+    }
+
+private:
+    // lowbias32 integer hash (a bijection, so distinct counters never collide within a stream)
+    static juce::uint32 mix(juce::uint32 x) noexcept
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    static float toBipolar(juce::uint32 x) noexcept
+    {
+        return (float) (x >> 8) * (1.0f / 8388608.0f) - 1.0f;
+    }
+
+    juce::uint32 keyA = 0;
+    juce::uint32 keyB = 0;
+    juce::uint32 counter = 0;
+};
@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    PluckParameters.h
+
+    Per-block parameter snapshot. The processor loads it once at the top of
+    processBlock through cached atomic pointers (no string lookups on the
+    audio thread) and voices read it from there. Only fields that changed
+    since the last block get pushed into the playing voices.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct PluckParameters
+{
+    // one bit per field, for pushing only what changed
+    enum Field : juce::uint32
+    {
+        gateField                 = 1 << 0,
+        stereoField               = 1 << 1,
+        fineTuneField             = 1 << 2,
+        decayField                = 1 << 3,
+        dampField                 = 1 << 4,
+        colorField                = 1 << 5,
+        stereoMicrotuneField      = 1 << 6,
+        exciterSlewRateField      = 1 << 7,
+        dampingCurveField         = 1 << 8,
+        gateDampingField          = 1 << 9,
+        maxVoicesField            = 1 << 10,
+
+        allFields                 = (1 << 11) - 1
+    };
+
+    bool gateEnabled = false;
+    bool stereoEnabled = true;
+    float fineTuneCents = 0.0f;
+    float decay = 3.0f;
+    float damp = 0.2f;
+    float color = 0.5f;
+    float stereoMicrotuneCents = 0.0f;
+    float exciterSlewRate = 1.0f;
+    float dampingCurve = 0.5f;
+    float gateDampingSeconds = 0.0f;
+    int maxVoices = 16;
+
+    // processor only, not pushed to voices: let PluckVoiceBudget lower the voice cap under load
+    bool adaptiveVoices = false;
+
+    // not an automatable parameter: the exciter noise seed, read by voices at note start
+    juce::uint32 noiseSeed = 0;
+
+    // PluckStringDelay::Interpolation for strings started this block, Lagrange3rd by default
+    int stringInterpolation = 1;
+
+    // Voices end once their output stays below this level for a whole period. noteTimer
+    // brings back the old pitch based note timer instead (read at note start).
+    float silenceFloorDb = -80.0f;
+    bool noteTimer = false;
+
+    // Derived: fine tune and stereo microtune as factors on the string period
+    // (TuningSystem::getPeriodInSamples), left and right. See updateDelayScales().
+    float delayScaleL = 1.0f;
+    float delayScaleR = 1.0f;
+
+    // Works the delay scales out from fine tune, microtune and stereo.
+    void updateDelayScales()
+    {
+        const float stereoMicrotune = stereoEnabled ? stereoMicrotuneCents : 0.0f;
+
+        delayScaleL = std::pow(2.0f, -(fineTuneCents - stereoMicrotune) / 1200.0f);
+        delayScaleR = std::pow(2.0f, -(fineTuneCents + stereoMicrotune) / 1200.0f);
+    }
+
+    // The same, but carried over from the previous snapshot when none of them moved
+    void updateDelayScales(const PluckParameters& previous)
+    {
+        if (fineTuneCents != previous.fineTuneCents || stereoMicrotuneCents != previous.stereoMicrotuneCents
+             || stereoEnabled != previous.stereoEnabled)
+        {
+            updateDelayScales();
+            return;
+        }
+
+        delayScaleL = previous.delayScaleL;
+        delayScaleR = previous.delayScaleR;
+    }
+
+    juce::uint32 getChangedFields(const PluckParameters& previous) const
+    {
+        juce::uint32 changed = 0;
+
+        if (gateEnabled != previous.gateEnabled)                    changed |= gateField;
+        if (stereoEnabled != previous.stereoEnabled)                changed |= stereoField;
+        if (fineTuneCents != previous.fineTuneCents)                changed |= fineTuneField;
+        if (decay != previous.decay)                                changed |= decayField;
+        if (damp != previous.damp)                                  changed |= dampField;
+        if (color != previous.color)                                changed |= colorField;
+        if (stereoMicrotuneCents != previous.stereoMicrotuneCents)  changed |= stereoMicrotuneField;
+        if (exciterSlewRate != previous.exciterSlewRate)            changed |= exciterSlewRateField;
+        if (dampingCurve != previous.dampingCurve)                  changed |= dampingCurveField;
+        if (gateDampingSeconds != previous.gateDampingSeconds)      changed |= gateDampingField;
+        if (maxVoices != previous.maxVoices)                        changed |= maxVoicesField;
+
+        return changed;
+    }
+};
+
+// Looks the raw parameter atomics up once, so loading a snapshot is just a handful of atomic reads
+class PluckParameterCache
+{
+public:
+    explicit PluckParameterCache(juce::AudioProcessorValueTreeState& apvts)
+        : gate(apvts.getRawParameterValue("GATE")),
+          stereo(apvts.getRawParameterValue("STEREO")),
+          fineTune(apvts.getRawParameterValue("FINETUNE")),
+          decay(apvts.getRawParameterValue("DECAY")),
+          damp(apvts.getRawParameterValue("DAMP")),
+          color(apvts.getRawParameterValue("COLOR")),
+          stereoMicrotune(apvts.getRawParameterValue("STEREOMICROTUNECENTS")),
+          exciterSlewRate(apvts.getRawParameterValue("EXCITERSLEWRATE")),
+          dampingCurve(apvts.getRawParameterValue("DAMPINGCURVE")),
+          gateDamping(apvts.getRawParameterValue("GATEDAMPING")),
+          maxVoices(apvts.getRawParameterValue("MAXVOICES")),
+          adaptiveVoices(apvts.getRawParameterValue("ADAPTIVEVOICES"))
+    {
+        jassert(gate != nullptr && stereo != nullptr && fineTune != nullptr && decay != nullptr
+             && damp != nullptr && color != nullptr && stereoMicrotune != nullptr && exciterSlewRate != nullptr
+             && dampingCurve != nullptr && gateDamping != nullptr && maxVoices != nullptr
+             && adaptiveVoices != nullptr);
+    }
+
+    PluckParameters load() const noexcept
+    {
+        PluckParameters p;
+        p.gateEnabled = gate->load(std::memory_order_relaxed) >= 0.5f;
+        p.stereoEnabled = stereo->load(std::memory_order_relaxed) >= 0.5f;
+        p.fineTuneCents = fineTune->load(std::memory_order_relaxed);
+        p.decay = decay->load(std::memory_order_relaxed);
+        p.damp = damp->load(std::memory_order_relaxed);
+        p.color = color->load(std::memory_order_relaxed);
+        p.stereoMicrotuneCents = stereoMicrotune->load(std::memory_order_relaxed);
+        p.exciterSlewRate = exciterSlewRate->load(std::memory_order_relaxed);
+        p.dampingCurve = dampingCurve->load(std::memory_order_relaxed);
+        p.gateDampingSeconds = gateDamping->load(std::memory_order_relaxed);
+        p.maxVoices = static_cast<int>(maxVoices->load(std::memory_order_relaxed));
+        p.adaptiveVoices = adaptiveVoices->load(std::memory_order_relaxed) >= 0.5f;
+        return p;
+    }
+
+private:
+    std::atomic<float>* gate;
+    std::atomic<float>* stereo;
+    std::atomic<float>* fineTune;
+    std::atomic<float>* decay;
+    std::atomic<float>* damp;
+    std::atomic<float>* color;
+    std::atomic<float>* stereoMicrotune;
+    std::atomic<float>* exciterSlewRate;
+    std::atomic<float>* dampingCurve;
+    std::atomic<float>* gateDamping;
+    std::atomic<float>* maxVoices;
+    std::atomic<float>* adaptiveVoices;
+};
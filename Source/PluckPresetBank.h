@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    PluckPresetBank.h
+
+    The programs, parsed once and kept in memory: every parameter's
+    normalised value and a complete tuning table with its periods worked
+    out. Switching programs (a host's setCurrentProgram() or a MIDI program
+    change) is then a handful of parameter writes and one pointer swap in
+    TuningSystem, the same amount of work whichever program it is, and safe
+    at the top of processBlock. The host and the editor hear about the new
+    values afterwards, from the message thread (notifyHost()).
+
+    The tables belong to the bank and never change once prepare() has run,
+    so TuningSystem can play them without copying.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TuningSystem.h"
+
+class PluckPresetBank
+{
+public:
+    struct Preset
+    {
+        juce::String name;
+        std::vector<float> values;              // normalised, one per parameter in the processor's order, -1 = leave it
+        TuningSystem::Table tuning;
+    };
+
+    // parameter ID and plain value, anything not listed keeps its default
+    using Setting = std::pair<const char*, float>;
+
+    // Not part of the sound: a program change leaves it where it is
+    static bool isPerformanceSetting(const juce::String& parameterID) { return parameterID == "MAXVOICES" || parameterID == "ADAPTIVEVOICES"; }
+
+    //==============================================================================
+    // Message thread, with the processor: looks the parameters up and builds the factory programs.
+    void build(juce::AudioProcessor& processor, TuningSystem& tuningSystem)
+    {
+        parameters.clear();
+
+        for (auto* p : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(p))
+                parameters.push_back(ranged);
+
+        presets.clear();
+
+        addFactoryPreset(tuningSystem, "Init", TuningSystem::Preset::equalTemperament, {});
+
+        addFactoryPreset(tuningSystem, "Nylon", TuningSystem::Preset::equalTemperament,
+                         { { "DECAY", 4.0f }, { "DAMP", 0.35f }, { "COLOR", 0.4f }, { "EXCITERSLEWRATE", 0.6f } });
+
+        addFactoryPreset(tuningSystem, "Harpsichord", TuningSystem::Preset::wellTemperament,
+                         { { "DECAY", 6.0f }, { "DAMP", 0.1f }, { "COLOR", 0.75f }, { "DAMPINGCURVE", 0.6f } });
+
+        addFactoryPreset(tuningSystem, "Koto", TuningSystem::Preset::pythagorean,
+                         { { "DECAY", 3.0f }, { "DAMP", 0.25f }, { "COLOR", 0.65f }, { "STEREOMICROTUNECENTS", 1.5f } });
+
+        addFactoryPreset(tuningSystem, "Dulcimer", TuningSystem::Preset::justIntonation,
+                         { { "DECAY", 10.0f }, { "DAMP", 0.05f }, { "COLOR", 0.7f }, { "STEREOMICROTUNECENTS", 3.0f } });
+
+        addFactoryPreset(tuningSystem, "Lute", TuningSystem::Preset::meantone,
+                         { { "DECAY", 3.5f }, { "DAMP", 0.3f }, { "COLOR", 0.45f }, { "EXCITERSLEWRATE", 0.5f } });
+
+        addFactoryPreset(tuningSystem, "Muted", TuningSystem::Preset::equalTemperament,
+                         { { "GATE", 1.0f }, { "GATEDAMPING", 0.3f }, { "DECAY", 1.0f }, { "DAMP", 0.5f }, { "COLOR", 0.35f } });
+
+        addFactoryPreset(tuningSystem, "Long Ring", TuningSystem::Preset::equalTemperament,
+                         { { "DECAY", 30.0f }, { "DAMP", 0.0f }, { "COLOR", 0.55f }, { "DAMPINGCURVE", 0.7f }, { "STEREOMICROTUNECENTS", 2.0f } });
+    }
+
+    // Not while the audio thread runs (prepareToPlay)
+    void prepare(double sampleRate)
+    {
+        for (auto& preset : presets)
+            preset.tuning.updatePeriods(sampleRate);
+    }
+
+    int size() const noexcept { return (int) presets.size(); }
+    bool contains(int index) const noexcept { return juce::isPositiveAndBelow(index, size()); }
+
+    juce::String getName(int index) const { return contains(index) ? presets[(size_t) index].name : juce::String(); }
+
+    // Message thread: the name only, nothing the audio thread reads
+    void setName(int index, const juce::String& newName)
+    {
+        if (contains(index))
+            presets[(size_t) index].name = newName;
+    }
+
+    //==============================================================================
+    // Top of processBlock (or any thread while the audio isn't running). Writes the values
+    // straight into the parameters, which is what the block's parameter snapshot reads, and
+    // tells no one: call notifyHost() from the message thread afterwards. True if the tuning
+    // changed, playing notes can then glide over to it.
+    bool apply(int index, TuningSystem& tuningSystem)
+    {
+        if (! contains(index))
+            return false;
+
+        const auto& preset = presets[(size_t) index];
+
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            auto* parameter = parameters[i];
+            const float value = preset.values[i];
+
+            // the performance settings keep their own value
+            if (value >= 0.0f && parameter->getValue() != value)
+                parameter->setValue(value);
+        }
+
+        return tuningSystem.selectTable(preset.tuning);
+    }
+
+    // Message thread, after apply(): the host and the parameter attachments get the program's
+    // parameters, each one as a gesture so automation records it like a move of the control.
+    // Whatever the parameter holds by now is sent, a later change isn't undone.
+    void notifyHost(int index)
+    {
+        if (! contains(index))
+            return;
+
+        const auto& preset = presets[(size_t) index];
+
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            if (preset.values[i] < 0.0f)
+                continue;
+
+            auto* parameter = parameters[i];
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost(parameter->getValue());
+            parameter->endChangeGesture();
+        }
+    }
+
+private:
+    void addFactoryPreset(TuningSystem& tuningSystem, const juce::String& name, TuningSystem::Preset tuning,
+                          std::initializer_list<Setting> settings)
+    {
+        Preset preset;
+        preset.name = name;
+
+        for (auto* parameter : parameters)
+        {
+            const auto id = parameter->getParameterID();
+
+            if (isPerformanceSetting(id))
+                preset.values.push_back(-1.0f);
+            else if (id == "TUNING_TYPE")
+                preset.values.push_back(parameter->convertTo0to1((float) tuning));
+            else
+                preset.values.push_back(parameter->getDefaultValue());
+        }
+
+        for (const auto& setting : settings)
+            for (size_t i = 0; i < parameters.size(); ++i)
+                if (parameters[i]->getParameterID() == setting.first)
+                    preset.values[i] = parameters[i]->convertTo0to1(setting.second);
+
+        TuningSystem::makePreset(tuning, preset.tuning);
+        tuningSystem.stamp(preset.tuning);
+        preset.tuning.updatePeriods(44100.0);
+
+        presets.push_back(std::move(preset));
+    }
+
+    std::vector<juce::RangedAudioParameter*> parameters;
+    std::vector<Preset> presets;
+};
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    PluckRamp.h
+
+    Linear per-sample ramp for the string's loop coefficients (feedback,
+    damping, damping curve). A new target only sets a step and a range, so
+    the cost per sample is one add and a clamp however often the host moves
+    a parameter. The clamp also keeps float rounding from overshooting.
+
+    PluckVoiceBank runs the same arithmetic per lane, so both engines glide
+    the same way.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct PluckRamp
+{
+    // how long a parameter change takes to reach the strings
+    static constexpr double rampSeconds = 0.02;
+
+    static int getRampSamples(double sampleRate) noexcept
+    {
+        return juce::jmax(1, juce::roundToInt(sampleRate * rampSeconds));
+    }
+
+    void snapTo(float newValue) noexcept
+    {
+        value = target = low = high = newValue;
+        step = 0.0f;
+    }
+
+    // Heads for newTarget from wherever the ramp is now, in rampSamples samples (0 jumps).
+    void setTarget(float newTarget, int rampSamples) noexcept
+    {
+        if (rampSamples <= 0)
+        {
+            snapTo(newTarget);
+            return;
+        }
+
+        if (newTarget == target)
+            return;
+
+        target = newTarget;
+        step = (target - value) / (float) rampSamples;
+        low = juce::jmin(value, target);
+        high = juce::jmax(value, target);
+    }
+
+    float getNextValue() noexcept
+    {
+        value = juce::jmin(high, juce::jmax(low, value + step));
+        return value;
+    }
+
+    // Where getNextValue() would be after numSamples calls, for whoever ran the ramp elsewhere.
+    void skip(int numSamples) noexcept
+    {
+        value = juce::jmin(high, juce::jmax(low, value + step * (float) numSamples));
+    }
+
+    bool isRamping() const noexcept { return value != target; }
+
+    // samples left until the target, 0 once it's there
+    int getRemainingSamples() const noexcept
+    {
+        return isRamping() && step != 0.0f ? juce::jmax(1, juce::roundToInt(std::abs((target - value) / step))) : 0;
+    }
+
+    float value = 0.0f, target = 0.0f, step = 0.0f, low = 0.0f, high = 0.0f;
+};
@@ -0,0 +1,343 @@
+/*
+  ==============================================================================
+
+    PluckRenderPool.h
+
+    A few realtime worker threads that help the audio thread render voices.
+    PluckSynth cuts a block into tasks (runs of voices, or runs of SIMD
+    groups in the voice bank), every thread claims tasks until none are
+    left, and each task adds into its own scratch buffer. The audio thread
+    then sums the scratch buffers in task order, so the output only depends
+    on how the block was cut, never on which thread got which task.
+
+    Handoff is one atomic word: job generation, task count and next task.
+    Publishing a job is a store, claiming a task a compare-exchange. Each
+    task also has a state word (generation and pending / running / done),
+    and whoever claims a task still has to move it from pending to running
+    before it renders it. Workers spin for a short while after their last
+    task and then sleep; only a sleeping worker costs the audio thread a
+    semaphore post. The audio thread works through the tasks itself, then
+    takes over any task a worker claimed but hasn't started (it was
+    preempted in between, say), and only waits for tasks that are actually
+    being rendered, so a worker that is slow to wake up or gets descheduled
+    before it starts never holds up the block.
+
+    Nothing here allocates or locks after prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+class PluckRenderPool
+{
+public:
+    static constexpr int maxWorkers = 7;
+    static constexpr int maxTasks = maxWorkers + 1;
+
+    // Adds into scratch over [startSample, startSample + numSamples). Scratch has the
+    // output's channel count (one or two) and is cleared over that range beforehand.
+    using Task = void (*) (void* context, int task, juce::AudioBuffer<float>& scratch, int startSample, int numSamples);
+
+    PluckRenderPool() = default;
+    ~PluckRenderPool() { stop(); }
+
+    // Not realtime safe. Starts numWorkersToUse threads (0 just stops them) with
+    // scratch space for blocks up to maxBlockSize.
+    void prepare(int numWorkersToUse, int maxBlockSize, double sampleRate)
+    {
+        stop();
+
+        numWorkersToUse = juce::jlimit(0, maxWorkers, numWorkersToUse);
+        scratchSize = maxBlockSize;
+
+        for (auto& s : scratch)
+            s.setSize(2, numWorkersToUse > 0 ? maxBlockSize : 0);
+
+        const auto options = juce::Thread::RealtimeOptions{}
+                                 .withApproximateAudioProcessingTime(juce::jmax(1, maxBlockSize), sampleRate);
+
+        for (int i = 0; i < numWorkersToUse; ++i)
+        {
+            auto* worker = workers.add(new Worker(*this, i));
+
+            // no realtime scheduling on this system (or not allowed to): still better than nothing
+            if (! worker->startRealtimeThread(options))
+                worker->startThread(juce::Thread::Priority::highest);
+        }
+    }
+
+    // Not realtime safe.
+    void stop()
+    {
+        for (auto* worker : workers)
+            worker->signalThreadShouldExit();
+
+        for (auto* worker : workers)
+        {
+            worker->wake.post();
+            worker->stopThread(1000);
+        }
+
+        workers.clear();
+    }
+
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+    // Whether run() can take this block: workers running and the scratch big enough.
+    bool canRun(int endSample) const noexcept { return ! workers.isEmpty() && endSample <= scratchSize; }
+
+    // Audio thread. Runs tasks 0 .. numTasks - 1 on the workers and this thread, then
+    // adds the scratch buffers into output in task order.
+    void run(Task task, void* context, int numTasks, juce::AudioBuffer<float>& output, int startSample, int numSamples)
+    {
+        jassert(canRun(startSample + numSamples));
+
+        numTasks = juce::jlimit(1, maxTasks, numTasks);
+
+        job.task = task;
+        job.context = context;
+        job.numChannels = juce::jmin(2, output.getNumChannels());
+        job.startSample = startSample;
+        job.numSamples = numSamples;
+
+        generation = (generation + 1) & 0xffffffff;
+
+        for (int i = 0; i < numTasks; ++i)
+            taskState[(size_t) i].store(makeState(generation, taskPending), std::memory_order_relaxed);
+
+        // everything above is released with the new word, the workers read it after a successful claim
+        claimWord.store((generation << 32) | ((juce::uint64) numTasks << 16), std::memory_order_seq_cst);
+
+        // one post per sleep: a worker that is slow to wake doesn't pile them up
+        for (auto* worker : workers)
+            if (worker->sleeping.exchange(false, std::memory_order_seq_cst))
+                worker->wake.post();
+
+        int t;
+        juce::uint64 claimedGeneration;
+        while (claimTask(t, claimedGeneration))
+            if (startTask(t, claimedGeneration))
+                runTask(t, claimedGeneration);
+
+        // every task is claimed now. One that is still pending belongs to a worker that hasn't
+        // got to it, render it here; only a task that is running right now is worth waiting for.
+        for (int i = 0; i < numTasks; ++i)
+        {
+            if (startTask(i, generation))
+            {
+                runTask(i, generation);
+                continue;
+            }
+
+            while (taskState[(size_t) i].load(std::memory_order_acquire) != makeState(generation, taskDone))
+                pause();
+        }
+
+        for (int i = 0; i < numTasks; ++i)
+            for (int ch = 0; ch < job.numChannels; ++ch)
+                output.addFrom(ch, startSample, scratch[(size_t) i], ch, startSample, numSamples);
+    }
+
+private:
+    struct Job
+    {
+        Task task = nullptr;
+        void* context = nullptr;
+        int numChannels = 2;
+        int startSample = 0;
+        int numSamples = 0;
+    };
+
+    // What a worker sleeps on. juce::WaitableEvent::signal() takes a mutex, so a worker
+    // descheduled while holding it would leave the audio thread waiting on it; posting an
+    // OS semaphore is one system call and no lock. It counts, a post that finds the worker
+    // awake only costs it an extra trip round its loop.
+    class WakeSemaphore
+    {
+    public:
+       #if JUCE_WINDOWS
+        WakeSemaphore()  : handle(CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr)) {}
+        ~WakeSemaphore() { CloseHandle(handle); }
+
+        void post() noexcept { ReleaseSemaphore(handle, 1, nullptr); }
+        void wait() noexcept { WaitForSingleObject(handle, INFINITE); }
+       #elif JUCE_MAC || JUCE_IOS
+        WakeSemaphore()  : handle(dispatch_semaphore_create(0)) {}
+        ~WakeSemaphore() { dispatch_release(handle); }
+
+        void post() noexcept { dispatch_semaphore_signal(handle); }
+        void wait() noexcept { dispatch_semaphore_wait(handle, DISPATCH_TIME_FOREVER); }
+       #else
+        WakeSemaphore()  { sem_init(&handle, 0, 0); }
+        ~WakeSemaphore() { sem_destroy(&handle); }
+
+        void post() noexcept { sem_post(&handle); }
+        void wait() noexcept { while (sem_wait(&handle) != 0 && errno == EINTR) {} }
+       #endif
+
+    private:
+       #if JUCE_WINDOWS
+        HANDLE handle;
+       #elif JUCE_MAC || JUCE_IOS
+        dispatch_semaphore_t handle;
+       #else
+        sem_t handle;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(WakeSemaphore)
+    };
+
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(PluckRenderPool& p, int index)
+            : juce::Thread("Plucks render " + juce::String(index + 1)), pool(p) {}
+
+        void run() override
+        {
+            int idle = 0;
+
+            while (! threadShouldExit())
+            {
+                int t;
+                juce::uint64 claimedGeneration;
+                if (pool.claimTask(t, claimedGeneration))
+                {
+                    // the audio thread may have taken it over already
+                    if (pool.startTask(t, claimedGeneration))
+                        pool.runTask(t, claimedGeneration);
+
+                    idle = 0;
+                    continue;
+                }
+
+                // the next sub-block is often only a few microseconds away
+                if (++idle < spinsBeforeSleep)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                sleeping.store(true, std::memory_order_seq_cst);
+
+                if (! pool.hasUnclaimedTask() && ! threadShouldExit())
+                    wake.wait();
+
+                sleeping.store(false, std::memory_order_relaxed);
+                idle = 0;
+            }
+        }
+
+        static constexpr int spinsBeforeSleep = 256;
+
+        std::atomic<bool> sleeping { false };
+        WakeSemaphore wake;
+
+    private:
+        PluckRenderPool& pool;
+    };
+
+    // claim word: generation (32 bits) | number of tasks (16) | next task (16)
+    static int getNext(juce::uint64 w) noexcept  { return (int) (w & 0xffff); }
+    static int getTotal(juce::uint64 w) noexcept { return (int) ((w >> 16) & 0xffff); }
+
+    bool hasUnclaimedTask() const noexcept
+    {
+        const auto w = claimWord.load(std::memory_order_seq_cst);
+        return getNext(w) < getTotal(w);
+    }
+
+    bool claimTask(int& task, juce::uint64& claimedGeneration) noexcept
+    {
+        auto w = claimWord.load(std::memory_order_acquire);
+
+        while (getNext(w) < getTotal(w))
+        {
+            // a word from an older job fails here, its generation bits no longer match
+            if (claimWord.compare_exchange_weak(w, w + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                task = getNext(w);
+                claimedGeneration = w >> 32;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // task state word: generation (32 bits) | state (2)
+    enum TaskState { taskPending, taskRunning, taskDone };
+
+    static juce::uint64 makeState(juce::uint64 gen, TaskState state) noexcept { return (gen << 2) | (juce::uint64) state; }
+
+    // Pending to running, true for exactly one thread per task and job. A worker that
+    // claimed from an older job fails here too.
+    bool startTask(int t, juce::uint64 gen) noexcept
+    {
+        auto expected = makeState(gen, taskPending);
+        return taskState[(size_t) t].compare_exchange_strong(expected, makeState(gen, taskRunning),
+                                                            std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+
+    // a spin-wait hint, lets the core (and its hyperthread sibling) breathe while we poll
+    static void pause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && defined (_MSC_VER)
+        __yield();
+       #elif JUCE_ARM
+        __asm__ __volatile__ ("yield");
+       #else
+        std::this_thread::yield();
+       #endif
+    }
+
+    void runTask(int t, juce::uint64 gen) noexcept
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        auto& s = scratch[(size_t) t];
+
+        // referencing constructor, no allocation
+        juce::AudioBuffer<float> view(s.getArrayOfWritePointers(), job.numChannels, s.getNumSamples());
+
+        for (int ch = 0; ch < job.numChannels; ++ch)
+            view.clear(ch, job.startSample, job.numSamples);
+
+        job.task(job.context, t, view, job.startSample, job.numSamples);
+
+        taskState[(size_t) t].store(makeState(gen, taskDone), std::memory_order_release);
+    }
+
+    Job job;
+    juce::uint64 generation = 0;                    // audio thread only
+    std::atomic<juce::uint64> claimWord { 0 };
+    std::array<std::atomic<juce::uint64>, maxTasks> taskState {};
+
+    std::array<juce::AudioBuffer<float>, maxTasks> scratch;
+    int scratchSize = 0;
+
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE(PluckRenderPool)
+};
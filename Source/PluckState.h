@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    PluckState.h
+
+    What getStateInformation() saves, as a small versioned binary blob
+    instead of the APVTS tree through XML. Parameters go in by ID (a
+    state from a build with more or fewer parameters still loads), then
+    the processor's own settings, the program and the whole tuning table,
+    so a custom .tun or .scl comes back without the file.
+
+    A tuning that repeats 12 pitch classes with every key mapped (the
+    presets, .tun files) is stored as those 12 offsets, anything else note
+    by note. With today's 13 parameters a state is about 280 bytes (the
+    parameter IDs are two thirds of it), about 760 with a note-by-note
+    tuning.
+
+    Layout: "PLKS", the format version and the size of what follows, then
+    the fields in the order read() takes them. A newer version only
+    appends; read() stops at what it knows and skips the rest.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TuningSystem.h"
+
+struct PluckState
+{
+    static constexpr int formatVersion = 1;
+
+    static juce::uint32 getMagic() noexcept { return juce::ByteOrder::littleEndianInt("PLKS"); }
+
+    std::vector<std::pair<juce::String, float>> parameters;     // ID and plain (not normalised) value
+
+    juce::uint32 noiseSeed = 0;
+    int stringInterpolation = 1;
+    float silenceFloorDb = -80.0f;
+    bool noteTimer = false;
+    bool mpeEnabled = false;
+    float pitchBendRange = 2.0f;
+
+    int program = 0;
+    TuningSystem::Table tuning;
+
+    //==============================================================================
+    void write(juce::MemoryBlock& destData) const
+    {
+        juce::MemoryOutputStream out(destData, false);
+
+        out.writeInt((int) getMagic());
+        out.writeCompressedInt(formatVersion);
+
+        // filled in at the end
+        const auto sizePosition = out.getPosition();
+        out.writeInt(0);
+
+        out.writeCompressedInt((int) parameters.size());
+
+        for (const auto& parameter : parameters)
+        {
+            out.writeString(parameter.first);
+            out.writeFloat(parameter.second);
+        }
+
+        out.writeInt((int) noiseSeed);
+        out.writeByte((char) stringInterpolation);
+        out.writeFloat(silenceFloorDb);
+        out.writeBool(noteTimer);
+        out.writeBool(mpeEnabled);
+        out.writeFloat(pitchBendRange);
+
+        out.writeCompressedInt(program);
+        writeTuning(out, tuning);
+
+        const auto end = out.getPosition();
+        out.setPosition(sizePosition);
+        out.writeInt((int) (end - sizePosition - 4));
+        out.setPosition(end);
+    }
+
+    // False if the data isn't one of these (an older, XML state) or is cut short
+    bool read(const void* data, int sizeInBytes)
+    {
+        if (data == nullptr || sizeInBytes < 8)
+            return false;
+
+        juce::MemoryInputStream in(data, (size_t) sizeInBytes, false);
+
+        if ((juce::uint32) in.readInt() != getMagic())
+            return false;
+
+        const int version = in.readCompressedInt();
+        const int size = in.readInt();
+        const auto end = in.getPosition() + size;
+
+        // a state cut short reads back as zeros, that's not one to load
+        if (version < 1 || size < 0 || size > in.getNumBytesRemaining())
+            return false;
+
+        const int numParameters = in.readCompressedInt();
+        if (numParameters < 0 || numParameters > size)
+            return false;
+
+        parameters.clear();
+
+        for (int i = 0; i < numParameters && ! in.isExhausted(); ++i)
+        {
+            auto id = in.readString();
+            parameters.emplace_back(std::move(id), in.readFloat());
+        }
+
+        noiseSeed = (juce::uint32) in.readInt();
+        stringInterpolation = in.readByte();
+        silenceFloorDb = in.readFloat();
+        noteTimer = in.readBool();
+        mpeEnabled = in.readBool();
+        pitchBendRange = in.readFloat();
+
+        program = in.readCompressedInt();
+
+        // a later version's fields come after this
+        return readTuning(in, tuning) && in.getPosition() <= end;
+    }
+
+private:
+    static constexpr int pitchClasses = 12;
+
+    static bool repeatsPitchClasses(const TuningSystem::Table& table)
+    {
+        for (int note = 0; note < TuningSystem::numNotes; ++note)
+            if (! table.noteMapped[(size_t) note]
+                 || table.centDeviations[(size_t) note] != table.centDeviations[(size_t) (note % pitchClasses)])
+                return false;
+
+        return true;
+    }
+
+    static void writeTuning(juce::OutputStream& out, const TuningSystem::Table& table)
+    {
+        out.writeString(table.name);
+        out.writeCompressedInt(table.preset);
+
+        const bool compact = repeatsPitchClasses(table);
+        out.writeBool(compact);
+
+        if (compact)
+        {
+            for (int note = 0; note < pitchClasses; ++note)
+                out.writeFloat(table.centDeviations[(size_t) note]);
+
+            return;
+        }
+
+        for (const float cents : table.centDeviations)
+            out.writeFloat(cents);
+
+        // the mapped keys as bits, eight to a byte
+        for (int note = 0; note < TuningSystem::numNotes; note += 8)
+        {
+            juce::uint8 bits = 0;
+
+            for (int bit = 0; bit < 8; ++bit)
+                if (table.noteMapped[(size_t) (note + bit)])
+                    bits |= (juce::uint8) (1 << bit);
+
+            out.writeByte((char) bits);
+        }
+    }
+
+    static bool readTuning(juce::InputStream& in, TuningSystem::Table& table)
+    {
+        table = TuningSystem::Table {};
+        table.name = in.readString();
+        table.preset = in.readCompressedInt();
+
+        if (table.preset > (int) TuningSystem::Preset::meantone)
+            table.preset = -1;
+
+        if (in.readBool())
+        {
+            std::array<float, pitchClasses> deviations {};
+
+            for (auto& cents : deviations)
+                cents = in.readFloat();
+
+            const auto name = table.name;
+            table.setPitchClasses(deviations, name);
+        }
+        else
+        {
+            for (auto& cents : table.centDeviations)
+                cents = in.readFloat();
+
+            for (int note = 0; note < TuningSystem::numNotes; note += 8)
+            {
+                const auto bits = (juce::uint8) in.readByte();
+
+                for (int bit = 0; bit < 8; ++bit)
+                    table.noteMapped[(size_t) (note + bit)] = (bits >> bit) & 1;
+            }
+        }
+
+        for (const float cents : table.centDeviations)
+            if (! std::isfinite(cents) || std::abs(cents) > 12000.0f)
+                return false;
+
+        return true;
+    }
+};
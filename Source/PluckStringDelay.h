@@ -0,0 +1,282 @@
+/*
+  ==============================================================================
+
+    PluckStringDelay.h
+
+    The string's delay line. Replaces juce::dsp::DelayLine in the reference
+    loop: one channel, a power-of-two ring sized to the note's period (a 40
+    sample string walks 64 floats instead of 32 KB), wraparound by masking,
+    and a choice of fractional read.
+
+    The ring indexing and the interpolators follow juce::dsp::DelayLine, so
+    Lagrange3rd sounds the same as before. The ring helpers are shared with
+    PluckVoiceBank, which keeps its lanes the same way.
+
+    Block API: beginBlock() copies the hot state into a small cursor that
+    lives in registers for the length of the loop, endBlock() puts it back.
+    read() uses the weights of the last setDelay(), read(delay) works them
+    out for every sample instead (pitch bend): no ring resizing or member
+    writes per call, reserve() has made room for the whole sweep up front.
+
+    The ring memory itself belongs to PluckVoiceArena, setBuffer() hands it
+    over in prepareToPlay.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PluckStringDelay
+{
+public:
+    enum class Interpolation
+    {
+        Linear = 0,
+        Lagrange3rd,        // the original sound
+        Thiran              // first order allpass, flat magnitude, brightest
+    };
+
+    static constexpr int maxSize = 8192;            // same as PluckVoice::maxBufferSize
+
+    //==============================================================================
+    // Smallest power of two ring that holds every tap for this delay.
+    static int getRingSizeFor(float delay, int capacity = maxSize) noexcept
+    {
+        const int needed = juce::jlimit(4, capacity, static_cast<int>(delay) + 4);
+        return juce::jmin(capacity, juce::nextPowerOfTwo(needed));
+    }
+
+    // Re-lays a ring out for a bigger size when the period grows mid-note (fine tune).
+    // History stays in order, anything older than the old ring reads as zero.
+    static void growRing(float* ring, int oldSize, int newSize, int& writePos) noexcept
+    {
+        std::rotate(ring, ring + (writePos & (oldSize - 1)), ring + oldSize); // oldest first
+        std::fill(ring + oldSize, ring + newSize, 0.0f);
+        writePos = oldSize;
+    }
+
+    // Integer tap and read weights, as juce::dsp::DelayLine would use them.
+    // Reads are k1 * tap1 + k2 * tap2 + k3 * tap3 + k4 * tap4 + allpass * (tap1 - previous read),
+    // with tap1 'offset' samples old and the others one sample older each.
+    struct ReadWeights
+    {
+        int offset = 1;
+        float frac = 0.0f;
+        float k1 = 1.0f, k2 = 0.0f, k3 = 0.0f, k4 = 0.0f;
+        float allpass = 0.0f;
+    };
+
+    static ReadWeights getReadWeights(float delay, Interpolation interpolation, int capacity = maxSize) noexcept
+    {
+        switch (interpolation)
+        {
+            case Interpolation::Linear:     return getReadWeights<Interpolation::Linear>(delay, capacity);
+            case Interpolation::Thiran:     return getReadWeights<Interpolation::Thiran>(delay, capacity);
+            case Interpolation::Lagrange3rd:
+            default:                        return getReadWeights<Interpolation::Lagrange3rd>(delay, capacity);
+        }
+    }
+
+    // The same with the interpolation fixed at compile time, for PluckVoice's specialised kernels
+    template <Interpolation interpolation>
+    static ReadWeights getReadWeights(float delay, int capacity = maxSize) noexcept
+    {
+        const float d = juce::jlimit(2.0f, static_cast<float>(capacity - 4), delay);
+        int delayInt = static_cast<int>(std::floor(d));
+        float frac = d - static_cast<float>(delayInt);
+
+        ReadWeights w;
+
+        if (interpolation == Interpolation::Linear)
+        {
+            w.k1 = 1.0f - frac;
+            w.k2 = frac;
+        }
+        else if (interpolation == Interpolation::Thiran)
+        {
+            if (frac < 0.618f && delayInt >= 1)
+            {
+                frac += 1.0f;
+                delayInt -= 1;
+            }
+
+            w.k1 = 0.0f;
+            w.k2 = 1.0f;
+            w.allpass = (1.0f - frac) / (1.0f + frac);
+        }
+        else
+        {
+            if (delayInt >= 1)
+            {
+                frac += 1.0f;
+                delayInt -= 1;
+            }
+
+            const float d1 = frac - 1.0f;
+            const float d2 = frac - 2.0f;
+            const float d3 = frac - 3.0f;
+
+            w.k1 = -d1 * d2 * d3 / 6.0f;
+            w.k2 = frac * d2 * d3 * 0.5f;
+            w.k3 = frac * -d1 * d3 * 0.5f;
+            w.k4 = frac * d1 * d2 / 6.0f;
+        }
+
+        w.offset = delayInt;
+        w.frac = frac;
+        return w;
+    }
+
+    //==============================================================================
+    // capacity is a power of two, at least as big as any ring this string will need.
+    // Back to the smallest ring: the next note sizes its own, and nothing past that
+    // gets touched until a note needs it.
+    void setBuffer(float* newRing, int newCapacity) noexcept
+    {
+        jassert(juce::isPowerOfTwo(newCapacity));
+
+        ring = newRing;
+        capacity = newCapacity;
+        size = juce::jmin(4, capacity);
+        reset();
+    }
+
+    // Only takes effect on the next reset(period), the allpass state doesn't survive a switch.
+    void setInterpolation(Interpolation newInterpolation) noexcept { pendingInterpolation = newInterpolation; }
+    Interpolation getInterpolation() const noexcept { return interpolation; }
+
+    // New note: size the ring for this period and clear just that much.
+    void reset(float periodSamples) noexcept
+    {
+        interpolation = pendingInterpolation;
+        size = getRingSizeFor(periodSamples, capacity);
+        reset();
+        setDelay(periodSamples);
+    }
+
+    void reset() noexcept
+    {
+        if (ring != nullptr)
+            std::fill(ring, ring + size, 0.0f);
+
+        writePos = 0;
+        allpassState = 0.0f;
+    }
+
+    // Grows the ring so every delay up to maxDelay can be read, history kept.
+    void reserve(float maxDelay) noexcept
+    {
+        const int needed = getRingSizeFor(maxDelay, capacity);
+
+        if (needed > size)
+        {
+            growRing(ring, size, needed, writePos);
+            size = needed;
+        }
+    }
+
+    void setDelay(float newDelay) noexcept
+    {
+        reserve(newDelay);
+
+        delay = newDelay;
+        weights = getReadWeights(newDelay, interpolation, capacity);
+    }
+
+    float getDelay() const noexcept { return delay; }
+    int getRingSize() const noexcept { return size; }
+
+    //==============================================================================
+    // Hot state for one block. Read before write, once per sample.
+    struct Block
+    {
+        float* ring;
+        int mask;
+        int writePos;
+        ReadWeights w;
+        Interpolation interpolation;
+        float allpassState;
+
+        float read() noexcept
+        {
+            switch (interpolation)
+            {
+                case Interpolation::Linear:     return read<Interpolation::Linear>();
+                case Interpolation::Thiran:     return read<Interpolation::Thiran>();
+                case Interpolation::Lagrange3rd:
+                default:                        return read<Interpolation::Lagrange3rd>();
+            }
+        }
+
+        // Modulated read: the weights for this sample's delay, same numbers setDelay() would give
+        float read(float sampleDelay) noexcept
+        {
+            w = getReadWeights(sampleDelay, interpolation, mask + 1);
+            return read();
+        }
+
+        // Both again for a kernel that knows the interpolation (it has to be this block's):
+        // nothing left to switch on per sample
+        template <Interpolation fixedInterpolation>
+        float read() noexcept
+        {
+            jassert(fixedInterpolation == interpolation);
+
+            const int p = writePos - w.offset;
+            const float value1 = ring[p & mask];
+            const float value2 = ring[(p - 1) & mask];
+
+            if (fixedInterpolation == Interpolation::Linear)
+                return value1 + w.frac * (value2 - value1);
+
+            if (fixedInterpolation == Interpolation::Thiran)
+            {
+                allpassState = value2 + w.allpass * (value1 - allpassState);
+                return allpassState;
+            }
+
+            const float value3 = ring[(p - 2) & mask];
+            const float value4 = ring[(p - 3) & mask];
+
+            // same grouping as juce::dsp::DelayLine (k2..k4 carry the frac factor here)
+            return value1 * w.k1 + (value2 * w.k2 + value3 * w.k3 + value4 * w.k4);
+        }
+
+        template <Interpolation fixedInterpolation>
+        float read(float sampleDelay) noexcept
+        {
+            w = getReadWeights<fixedInterpolation>(sampleDelay, mask + 1);
+            return read<fixedInterpolation>();
+        }
+
+        void write(float sample) noexcept
+        {
+            ring[writePos & mask] = sample;
+            ++writePos;
+        }
+    };
+
+    Block beginBlock() noexcept
+    {
+        return { ring, size - 1, writePos, weights, interpolation, allpassState };
+    }
+
+    void endBlock(const Block& block) noexcept
+    {
+        writePos = block.writePos & (size - 1);
+        allpassState = block.allpassState;
+    }
+
+private:
+    float* ring = nullptr;          // 'capacity' floats in the arena, only the first 'size' are in use
+    int capacity = 4;
+    int size = 4;
+    int writePos = 0;
+    float delay = 2.0f;
+    float allpassState = 0.0f;
+    ReadWeights weights;
+    Interpolation interpolation = Interpolation::Lagrange3rd;
+    Interpolation pendingInterpolation = Interpolation::Lagrange3rd;
+};
@@ -0,0 +1,776 @@
+/*
+  ==============================================================================
+
+    PluckSynth.h
+
+    Owns the voices and plays them, with a choice of render engine. The
+    reference engine is the stock per-voice loop in PluckVoice::renderNextBlock,
+    the voice bank engine renders every active string together in
+    PluckVoiceBank. Both take their buffers from one PluckVoiceArena, sized in
+    prepareVoiceMemory().
+
+    Note handling (re-excite, gate retrigger, stealing) happens here when the
+    MIDI event is reached, with PluckVoiceManager keeping track of which voice
+    has which note (and channel). Pitch wheel and pressure are kept per
+    channel and handed to the voices on that channel, see setMpeEnabled(). Only playing voices are visited and no voice is looked up
+    through RTTI. Blocks are split at MIDI events the way juce::Synthesiser
+    did it, no sub-block shorter than minimumSubBlockSize except the first.
+    The events come in as a PluckMidiQueue, already decoded.
+
+    With render threads prepared, a sub-block with enough playing voices is
+    cut into runs of voices (or of voice bank groups) and rendered on
+    PluckRenderPool. Note handling, re-excites in the voice bank, and
+    releasing finished voices all stay on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluckVoice.h"
+#include "PluckVoiceBank.h"
+#include "PluckVoiceArena.h"
+#include "PluckVoiceManager.h"
+#include "PluckRenderPool.h"
+#include "PluckTelemetry.h"
+#include "PluckMidiQueue.h"
+
+class PluckSynth
+{
+public:
+    enum class Engine
+    {
+        Reference,
+        VoiceBank
+    };
+
+    static constexpr int minimumSubBlockSize = 32;
+
+    // below this many voices per thread the handoff costs more than it saves
+    static constexpr int minimumVoicesPerTask = 4;
+
+    // Takes ownership. Add every voice before prepareVoiceBank().
+    PluckVoice* addVoice(PluckVoice* newVoice)
+    {
+        newVoice->setCurrentPlaybackSampleRate(sampleRate);
+        keyDown.push_back(false);
+        sustained.push_back(false);
+        return voices.add(newVoice);
+    }
+
+    int getNumVoices() const { return voices.size(); }
+    PluckVoice* getVoice(int index) const { return voices[index]; }
+
+    void setCurrentPlaybackSampleRate(double newRate)
+    {
+        stopAllVoices();
+        sampleRate = newRate;
+
+        for (auto* voice : voices)
+            voice->setCurrentPlaybackSampleRate(newRate);
+    }
+
+    // Hooks every voice up to the bank and sizes the voice manager. Call after all voices were added.
+    void prepareVoiceBank()
+    {
+        voiceBank.prepare(getNumVoices());
+        voiceManager.prepare(getNumVoices());
+
+        for (int i = 0; i < getNumVoices(); ++i)
+            voices[i]->setVoiceBank(&voiceBank, i);
+
+        voiceBank.setEnabled(engine == Engine::VoiceBank);
+    }
+
+    // Sizes every string and exciter for this sample rate and the lowest note that can
+    // reach the voices, then hands the pieces out. prepareToPlay only, it allocates.
+    void prepareVoiceMemory(double newSampleRate, int lowestNote)
+    {
+        voiceArena.prepare(newSampleRate, lowestNote, getNumVoices(), voiceBank.getNumPaddedLanes());
+
+        for (int i = 0; i < getNumVoices(); ++i)
+            voices[i]->setVoiceMemory(voiceArena, i);
+
+        voiceBank.setRings(voiceArena);
+    }
+
+    const PluckVoiceArena& getVoiceArena() const { return voiceArena; }
+
+    // Starts numWorkers render threads next to the audio thread, 0 stops them and renders
+    // everything on the audio thread. prepareToPlay / releaseResources only.
+    void prepareRenderThreads(int numWorkers, int maxBlockSize)
+    {
+        renderPool.prepare(numWorkers, maxBlockSize, sampleRate);
+        renderList.assign((size_t) juce::jmax(getNumVoices(), voiceBank.getNumGroups()), -1);
+    }
+
+    int getNumRenderThreads() const { return renderPool.getNumWorkers(); }
+
+    // Where steals, re-excites, voice ends and note-on / render times get counted. Optional.
+    void setTelemetry(PluckTelemetry* newTelemetry) { telemetry = newTelemetry; }
+
+    // Takes effect at the next stopAllVoices() or render, which stops every voice first:
+    // the two engines don't share string state.
+    void setEngine(Engine newEngine) { requestedEngine = newEngine; }
+    Engine getEngine() const { return requestedEngine.load(); }
+    PluckVoiceBank& getVoiceBank() { return voiceBank; }
+
+    //==============================================================================
+    // Note policy, set by the processor once per block.
+
+    // Past this many playing voices a new note steals the oldest one, or with
+    // stealQuietest the quietest one (the adaptive voice cap, see shedVoices())
+    void setVoiceLimit(int newLimit, bool stealQuietest = false)
+    {
+        voiceLimit = juce::jlimit(1, getNumVoices(), newLimit);
+        stealQuietestVoice = stealQuietest;
+    }
+
+    int getVoiceLimit() const { return voiceLimit; }
+
+    // Gate: a repeated note restarts its voice instead of re-exciting it, note-offs fade voices out
+    void setGateEnabled(bool shouldGate) { gateEnabled = shouldGate; }
+
+    // Without MPE the wheel bends every note on its channel by up to pitchBendRange
+    // semitones. With MPE (lower zone: channel 1 is the master, 2..16 carry one note
+    // each) a member channel bends its own note by up to 48 semitones plus 2 from the
+    // master channel, and its pressure holds just that string.
+    void setMpeEnabled(bool shouldUseMpe) { mpeEnabled = shouldUseMpe; }
+    bool isMpeEnabled() const { return mpeEnabled; }
+    void setPitchBendRange(float semitones) { pitchBendRange = semitones; }
+
+    static constexpr int mpeMasterChannel = 1;
+    static constexpr float mpeMemberBendRange = 48.0f;
+    static constexpr float mpeMasterBendRange = 2.0f;
+
+    int getNumActiveVoices() const { return voiceManager.getNumActive(); }
+    const PluckVoiceManager& getVoiceManager() const { return voiceManager; }
+
+    // Calls f(PluckVoice&) for every playing voice, oldest first.
+    template <typename Function>
+    void forEachActiveVoice(Function&& f)
+    {
+        for (int v = voiceManager.getOldest(); v >= 0;)
+        {
+            const int next = voiceManager.getNewer(v);
+            f(*voices.getUnchecked(v));
+            v = next;
+        }
+    }
+
+    //==============================================================================
+    // samplePosition is where in the current block the note lands, for re-excites
+    void noteOn(int midiNote, float velocity, int samplePosition = 0, int channel = 1)
+    {
+        const int playing = findVoice(midiNote, channel);
+
+        if (playing >= 0)
+        {
+            if (! gateEnabled)
+            {
+                // still ringing: pluck the same string again
+                voices.getUnchecked(playing)->scheduleReExcite(samplePosition, velocity);
+
+                if (telemetry != nullptr)
+                    telemetry->voiceReExcited();
+
+                keyDown[(size_t) playing] = true;
+                sustained[(size_t) playing] = false;
+                voiceManager.touch(playing);
+                return;
+            }
+
+            // gate: clear it and start fresh
+            stopVoice(playing);
+        }
+
+        if (voiceManager.getNumActive() >= voiceLimit || ! voiceManager.hasFreeVoice())
+        {
+            stopVoice(stealQuietestVoice ? findQuietestVoice(true) : voiceManager.getOldest());
+
+            if (telemetry != nullptr)
+                telemetry->voiceStolen();
+        }
+
+        const int voice = voiceManager.allocate(midiNote, channel);
+        if (voice < 0)
+            return;
+
+        keyDown[(size_t) voice] = true;
+        sustained[(size_t) voice] = false;
+        voices.getUnchecked(voice)->startNote(midiNote, velocity, getBendForChannel(channel), getPressureForChannel(channel));
+    }
+
+    void noteOff(int midiNote, float velocity, int channel = 1)
+    {
+        const int voice = findVoice(midiNote, channel);
+        if (voice < 0 || ! keyDown[(size_t) voice])
+            return;
+
+        keyDown[(size_t) voice] = false;
+
+        if (isSustainPedalDown(voiceManager.getChannelForVoice(voice)))
+            sustained[(size_t) voice] = true;
+        else
+            voices.getUnchecked(voice)->stopNote(velocity, true);
+    }
+
+    // One pedal per channel, like juce::Synthesiser. With MPE the master channel's pedal
+    // holds every note of the zone as well.
+    void handleSustainPedal(int channel, bool isDown)
+    {
+        if (! juce::isPositiveAndBelow(channel, numChannels))
+            return;
+
+        sustainPedalDown[(size_t) channel] = isDown;
+
+        if (isDown)
+            return;
+
+        for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+        {
+            if (sustained[(size_t) v] && ! isSustainPedalDown(voiceManager.getChannelForVoice(v)))
+            {
+                sustained[(size_t) v] = false;
+                voices.getUnchecked(v)->stopNote(1.0f, true);
+            }
+        }
+    }
+
+    // value is the raw 14 bit wheel position, 8192 is the centre
+    void pitchWheelMoved(int channel, int value)
+    {
+        if (! juce::isPositiveAndBelow(channel, numChannels))
+            return;
+
+        channelBend[(size_t) channel] = value < 8192 ? (float) (value - 8192) / 8192.0f
+                                                     : (float) (value - 8192) / 8191.0f;
+
+        const bool everyChannel = mpeEnabled && channel == mpeMasterChannel;
+
+        for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+        {
+            const int voiceChannel = voiceManager.getChannelForVoice(v);
+
+            if (everyChannel || voiceChannel == channel)
+                voices.getUnchecked(v)->setPitchBend(getBendForChannel(voiceChannel));
+        }
+    }
+
+    // Channel pressure, 0..127: every note on the channel (with MPE that's the one note)
+    void channelPressureChanged(int channel, int value)
+    {
+        if (! juce::isPositiveAndBelow(channel, numChannels))
+            return;
+
+        channelPressure[(size_t) channel] = (float) value / 127.0f;
+
+        for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+            if (voiceManager.getChannelForVoice(v) == channel)
+                voices.getUnchecked(v)->setPressure(channelPressure[(size_t) channel]);
+    }
+
+    // Poly aftertouch, 0..127: just this note
+    void aftertouchChanged(int channel, int midiNote, int value)
+    {
+        const int voice = findVoice(midiNote, channel);
+
+        if (voice >= 0)
+            voices.getUnchecked(voice)->setPressure((float) value / 127.0f);
+    }
+
+    // All notes/sound off from MIDI: the channel's notes tail off like a note-off would.
+    // With MPE the master channel's reaches the whole zone.
+    void allNotesOff(int channel)
+    {
+        if (! juce::isPositiveAndBelow(channel, numChannels))
+            return;
+
+        const bool everyChannel = mpeEnabled && channel == mpeMasterChannel;
+
+        for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+        {
+            if (! everyChannel && voiceManager.getChannelForVoice(v) != channel)
+                continue;
+
+            keyDown[(size_t) v] = false;
+            sustained[(size_t) v] = false;
+            voices.getUnchecked(v)->stopNote(0.0f, true);
+        }
+
+        if (everyChannel)
+            sustainPedalDown.fill(false);
+        else
+            sustainPedalDown[(size_t) channel] = false;
+    }
+
+    // Fades voices out, quietest first, until no more than cap are left that aren't already
+    // fading. The adaptive voice cap calls it at the top of a block once PluckVoiceBudget
+    // lowers the cap; the fades are short but never a cut. Returns how many it faded.
+    int shedVoices(int cap)
+    {
+        int playing = 0;
+
+        for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+            if (! isVoiceFading(v))
+                ++playing;
+
+        int shed = 0;
+
+        for (; playing > cap; --playing)
+        {
+            const int voice = findQuietestVoice(false);
+            if (voice < 0)
+                break;
+
+            voices.getUnchecked(voice)->shed();
+            ++shed;
+
+            if (telemetry != nullptr)
+                telemetry->voiceShed();
+        }
+
+        return shed;
+    }
+
+    // Mean square per output over the voice's last energy window, from whichever engine plays it
+    float getVoiceLevel(int voice) const
+    {
+        return voiceBank.isEnabled() ? voiceBank.getLevel(voice) : voices.getUnchecked(voice)->getLevel();
+    }
+
+    bool isVoiceFading(int voice) const
+    {
+        return voiceBank.isEnabled() ? voiceBank.isFading(voice) : voices.getUnchecked(voice)->isFadingOut();
+    }
+
+    // The playing voice that would be missed least: one already fading if fadingFirst, else the
+    // lowest level, the oldest of equals. Voices that haven't been measured yet (just plucked)
+    // only go when nothing else is left.
+    int findQuietestVoice(bool fadingFirst) const
+    {
+        int quietest = -1;
+        float lowest = std::numeric_limits<float>::max();
+
+        for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+        {
+            if (isVoiceFading(v))
+            {
+                if (fadingFirst)
+                    return v;
+
+                continue;
+            }
+
+            const float level = getVoiceLevel(v);
+
+            if (quietest < 0 || level < lowest)
+            {
+                quietest = v;
+                lowest = level;
+            }
+        }
+
+        return quietest >= 0 ? quietest : voiceManager.getOldest();
+    }
+
+    // Hard stop, no fade.
+    void stopVoice(int voice)
+    {
+        if (voice < 0)
+            return;
+
+        auto* v = voices.getUnchecked(voice);
+        v->stopNote(0.0f, false);
+        v->clearCurrentNote();
+        v->resetBuffers();
+
+        keyDown[(size_t) voice] = false;
+        sustained[(size_t) voice] = false;
+        voiceManager.release(voice);
+    }
+
+    // Hard stops every voice and picks up a new engine, on the audio thread or while it isn't running.
+    void stopAllVoices()
+    {
+        for (int i = 0; i < getNumVoices(); ++i)
+        {
+            auto* v = voices.getUnchecked(i);
+            v->stopNote(0.0f, false);
+            v->clearCurrentNote();
+            v->resetBuffers();
+        }
+
+        std::fill(keyDown.begin(), keyDown.end(), false);
+        std::fill(sustained.begin(), sustained.end(), false);
+        sustainPedalDown.fill(false);
+        voiceManager.reset();
+
+        engine = requestedEngine.load();
+        voiceBank.setEnabled(engine == Engine::VoiceBank && voiceBank.isPrepared());
+    }
+
+    // Same, from any thread: done at the start of the next render.
+    void requestStopAllVoices() { stopRequested = true; }
+
+    //==============================================================================
+    void renderNextBlock(juce::AudioBuffer<float>& buffer, const PluckMidiQueue& midi, int startSample, int numSamples)
+    {
+        if (stopRequested.exchange(false) || requestedEngine.load() != engine)
+            stopAllVoices();
+
+        const auto* event = midi.begin();
+        while (event != midi.end() && event->samplePosition < startSample)
+            ++event;
+
+        bool firstEvent = true;
+
+        for (; numSamples > 0; ++event)
+        {
+            if (event == midi.end())
+            {
+                renderVoices(buffer, startSample, numSamples);
+                return;
+            }
+
+            const int samplesToNextEvent = event->samplePosition - startSample;
+
+            if (samplesToNextEvent >= numSamples)
+            {
+                renderVoices(buffer, startSample, numSamples);
+                handleMidiEvent(*event);
+                ++event;
+                break;
+            }
+
+            if (samplesToNextEvent < (firstEvent ? 1 : minimumSubBlockSize))
+            {
+                handleMidiEvent(*event);
+                continue;
+            }
+
+            firstEvent = false;
+
+            renderVoices(buffer, startSample, samplesToNextEvent);
+            handleMidiEvent(*event);
+            startSample += samplesToNextEvent;
+            numSamples -= samplesToNextEvent;
+        }
+
+        for (; event != midi.end(); ++event)
+            handleMidiEvent(*event);
+    }
+
+    // The same from a juce::MidiBuffer (offline tools, benchmarks): decoded into the synth's
+    // own queue first. processBlock fills a PluckMidiQueue directly.
+    void renderNextBlock(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midi, int startSample, int numSamples)
+    {
+        midiScratch.clear();
+        midiScratch.addAll(midi);
+        renderNextBlock(buffer, midiScratch, startSample, numSamples);
+    }
+
+private:
+    void handleMidiEvent(const PluckMidiQueue::Event& event)
+    {
+        using Type = PluckMidiQueue::Type;
+        const int channel = event.channel;
+
+        switch (event.type)
+        {
+            case Type::noteOn:
+            {
+                const auto start = telemetry != nullptr ? PluckTelemetry::now() : 0;
+
+                noteOn(event.note, event.getFloatVelocity(), event.samplePosition, channel);
+
+                if (telemetry != nullptr)
+                    telemetry->noteOnTook(PluckTelemetry::now() - start);
+                break;
+            }
+
+            case Type::noteOff:             noteOff(event.note, event.getFloatVelocity(), channel); break;
+            case Type::pitchWheel:          pitchWheelMoved(channel, event.value); break;
+            case Type::channelPressure:     channelPressureChanged(channel, event.value); break;
+            case Type::aftertouch:          aftertouchChanged(channel, event.note, event.value); break;
+            case Type::allNotesOff:         allNotesOff(channel); break;
+            case Type::sustainPedal:        handleSustainPedal(channel, event.value != 0); break;
+
+            case Type::resetAllControllers:
+                pitchWheelMoved(channel, 8192);
+                channelPressureChanged(channel, 0);
+                break;
+
+            case Type::none:
+            default:
+                break;
+        }
+    }
+
+    // MPE notes are told apart by channel too, otherwise a note is a note whatever its channel
+    int findVoice(int midiNote, int channel) const
+    {
+        return mpeEnabled ? voiceManager.findVoice(midiNote, channel) : voiceManager.getVoiceForNote(midiNote);
+    }
+
+    float getBendForChannel(int channel) const
+    {
+        if (! juce::isPositiveAndBelow(channel, numChannels))
+            return 0.0f;
+
+        const float bend = channelBend[(size_t) channel];
+
+        if (! mpeEnabled)
+            return bend * pitchBendRange;
+
+        const float master = channelBend[(size_t) mpeMasterChannel] * mpeMasterBendRange;
+        return channel == mpeMasterChannel ? master : bend * mpeMemberBendRange + master;
+    }
+
+    float getPressureForChannel(int channel) const
+    {
+        return juce::isPositiveAndBelow(channel, numChannels) ? channelPressure[(size_t) channel] : 0.0f;
+    }
+
+    // whether a note on this channel is held by a pedal, its own or the MPE master's
+    bool isSustainPedalDown(int channel) const
+    {
+        if (mpeEnabled && sustainPedalDown[(size_t) mpeMasterChannel])
+            return true;
+
+        return juce::isPositiveAndBelow(channel, numChannels) && sustainPedalDown[(size_t) channel];
+    }
+
+    void renderVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        const int numActive = voiceManager.getNumActive();
+        if (numActive == 0)
+            return;
+
+        const auto start = telemetry != nullptr ? PluckTelemetry::now() : 0;
+
+        renderActiveVoices(buffer, startSample, numSamples);
+
+        if (telemetry != nullptr)
+            telemetry->voicesRendered(PluckTelemetry::now() - start, numActive, numSamples);
+    }
+
+    void renderActiveVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        if (! voiceBank.isEnabled())
+        {
+            const int tasks = getNumRenderTasks(startSample + numSamples, voiceManager.getNumActive());
+
+            if (tasks > 1)
+            {
+                renderListSize = 0;
+                for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+                    renderList[(size_t) renderListSize++] = v;
+
+                renderTasks = tasks;
+                renderPool.run(renderVoiceTask, this, tasks, buffer, startSample, numSamples);
+            }
+            else
+            {
+                for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+                    voices.getUnchecked(v)->renderNextBlock(buffer, startSample, numSamples);
+            }
+
+            for (int v = voiceManager.getOldest(); v >= 0;)
+            {
+                const int next = voiceManager.getNewer(v);
+                const auto* voice = voices.getUnchecked(v);
+
+                // faded out on its own
+                if (! voice->isPlayingNote())
+                {
+                    if (telemetry != nullptr)
+                    {
+                        if (voice->endedOnTimer())        telemetry->voiceTimedOut();
+                        else if (voice->endedOnSilence()) telemetry->voiceWentSilent();
+                    }
+
+                    voiceManager.release(v);
+                }
+
+                v = next;
+            }
+
+            return;
+        }
+
+        juce::ScopedNoDenormals noDenormals;
+
+        float* outL = buffer.getWritePointer(0);
+        float* outR = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1) : outL;
+
+        for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+            voices.getUnchecked(v)->syncVoiceBank();
+
+        const int endSample = startSample + numSamples;
+        int position = startSample;
+
+        // split at pending re-excites so they land on the same sample as in the reference loop,
+        // and every controlBlockSize samples while a fine tune glide or a pitch bend moves the delays
+        while (position < endSample)
+        {
+            int next = endSample;
+            bool gliding = false;
+
+            for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+            {
+                const auto* voice = voices.getUnchecked(v);
+                const int pending = voice->getPendingReExciteSample();
+                if (pending >= position && pending < next)
+                    next = pending;
+
+                gliding = gliding || voice->isDelayGliding() || voice->isPitchBending();
+            }
+
+            if (gliding)
+                next = juce::jmin(next, position + PluckVoice::controlBlockSize);
+
+            if (next > position)
+            {
+                renderVoiceBank(buffer, outL, outR, position, next - position);
+
+                if (gliding)
+                {
+                    for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+                    {
+                        auto* voice = voices.getUnchecked(v);
+                        if (voice->isDelayGliding() || voice->isPitchBending())
+                        {
+                            voice->advanceDelayGlide(next - position);
+                            voice->syncVoiceBank();
+                        }
+                    }
+                }
+            }
+
+            if (next < endSample)
+            {
+                for (int v = voiceManager.getOldest(); v >= 0; v = voiceManager.getNewer(v))
+                    if (voices.getUnchecked(v)->getPendingReExciteSample() == next)
+                        voices.getUnchecked(v)->applyPendingReExcite();
+            }
+
+            position = next;
+        }
+
+        for (int v = voiceManager.getOldest(); v >= 0;)
+        {
+            const int next = voiceManager.getNewer(v);
+
+            if (voiceBank.hasVoiceFinished(v))
+            {
+                if (telemetry != nullptr)
+                {
+                    if (voiceBank.endedOnTimer(v))        telemetry->voiceTimedOut();
+                    else if (voiceBank.endedOnSilence(v)) telemetry->voiceWentSilent();
+                }
+
+                voices.getUnchecked(v)->clearCurrentNote();
+                voiceManager.release(v);
+            }
+
+            v = next;
+        }
+    }
+
+    // 1 renders on the audio thread alone
+    int getNumRenderTasks(int endSample, int numActive) const
+    {
+        if (! renderPool.canRun(endSample))
+            return 1;
+
+        return juce::jmin(renderPool.getNumWorkers() + 1, numActive / minimumVoicesPerTask);
+    }
+
+    void renderVoiceBank(juce::AudioBuffer<float>& buffer, float* outL, float* outR, int startSample, int numSamples)
+    {
+        int tasks = getNumRenderTasks(startSample + numSamples, voiceManager.getNumActive());
+
+        if (tasks > 1)
+        {
+            renderListSize = 0;
+            for (int g = 0; g < voiceBank.getNumGroups(); ++g)
+                if (voiceBank.isGroupActive(g))
+                    renderList[(size_t) renderListSize++] = g;
+
+            tasks = juce::jmin(tasks, renderListSize);
+        }
+
+        if (tasks > 1)
+        {
+            renderTasks = tasks;
+            renderPool.run(renderGroupTask, this, tasks, buffer, startSample, numSamples);
+            voiceBank.endRender(numSamples);
+        }
+        else
+        {
+            voiceBank.render(outL + startSample, outR + startSample, numSamples);
+        }
+    }
+
+    // task t takes the t-th contiguous run of renderList, voices stay in age order
+    juce::Range<int> getTaskRange(int task) const
+    {
+        return { task * renderListSize / renderTasks, (task + 1) * renderListSize / renderTasks };
+    }
+
+    static void renderVoiceTask(void* context, int task, juce::AudioBuffer<float>& scratch, int startSample, int numSamples)
+    {
+        auto& synth = *static_cast<PluckSynth*>(context);
+
+        const auto range = synth.getTaskRange(task);
+
+        for (int i = range.getStart(); i < range.getEnd(); ++i)
+            synth.voices.getUnchecked(synth.renderList[(size_t) i])->renderNextBlock(scratch, startSample, numSamples);
+    }
+
+    static void renderGroupTask(void* context, int task, juce::AudioBuffer<float>& scratch, int startSample, int numSamples)
+    {
+        auto& synth = *static_cast<PluckSynth*>(context);
+
+        float* outL = scratch.getWritePointer(0, startSample);
+        float* outR = scratch.getNumChannels() > 1 ? scratch.getWritePointer(1, startSample) : outL;
+
+        const auto range = synth.getTaskRange(task);
+
+        for (int i = range.getStart(); i < range.getEnd(); ++i)
+            synth.voiceBank.renderGroup(synth.renderList[(size_t) i], outL, outR, numSamples);
+    }
+
+    juce::OwnedArray<PluckVoice> voices;
+    PluckVoiceManager voiceManager;
+    std::vector<bool> keyDown, sustained;
+    bool gateEnabled = false;
+
+    // per MIDI channel (1..16), what new notes on it start with, and its pedal
+    static constexpr int numChannels = 17;
+    std::array<float, numChannels> channelBend {};      // -1..1
+    std::array<float, numChannels> channelPressure {};  // 0..1
+    std::array<bool, numChannels> sustainPedalDown {};
+    bool mpeEnabled = false;
+    float pitchBendRange = 2.0f;
+    int voiceLimit = 16;
+    bool stealQuietestVoice = false;
+    double sampleRate = 44100.0;
+
+    Engine engine = Engine::VoiceBank;
+    std::atomic<Engine> requestedEngine { Engine::VoiceBank };
+    std::atomic<bool> stopRequested { false };
+
+    PluckVoiceBank voiceBank;
+    PluckVoiceArena voiceArena;
+
+    PluckRenderPool renderPool;
+    std::vector<int> renderList;    // what the current threaded render is cutting up
+    int renderListSize = 0;
+    int renderTasks = 1;
+
+    PluckTelemetry* telemetry = nullptr;
+    PluckMidiQueue midiScratch;         // for the juce::MidiBuffer renderNextBlock()
+};
@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    PluckTelemetry.h
+
+    What Plucks costs while it plays, cheap enough to leave on. The audio
+    thread is the only writer: it timestamps processBlock, every voice
+    render pass and every note-on with getHighResolutionTicks() and stores
+    plain counters into relaxed atomics. Any other thread can take a
+    Snapshot at any time without a lock; a snapshot may straddle a block,
+    which is fine for a readout.
+
+      block load    processBlock time over the block's deadline, last and
+                    peak, plus a histogram in 10% steps (the last bucket
+                    is everything at or over 100%: an overload)
+      voices        active now and peak, steals, re-excites, and how
+                    voices ended: note timer or silence floor
+      voice cap     the adaptive cap (ADAPTIVEVOICES) and how many voices
+                    it faded out
+      note-on       worst time for one note-on, stealing included
+      MIDI          events dropped because the block's PluckMidiQueue was full
+      render        voice render time per voice per sample
+
+    Resets are requested from anywhere and done by the audio thread at the
+    top of its next block, so it stays the only writer.
+
+    Startup times are the exception: setting the voices up, the last
+    prepareToPlay, opening the editor and building its second page, each
+    stored once by whoever did the work. A reset keeps them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PluckTelemetry
+{
+public:
+    static constexpr int numLoadBuckets = 11;   // 0-10% ... 90-100%, then >= 100%
+
+    struct Snapshot
+    {
+        float lastLoad = 0.0f;                  // 1 = the whole deadline
+        float peakLoad = 0.0f;
+        std::array<juce::uint32, numLoadBuckets> loadHistogram {};
+        juce::uint32 blocks = 0;
+        juce::uint32 overloads = 0;
+
+        int activeVoices = 0;
+        int peakVoices = 0;
+        juce::uint32 steals = 0;
+        juce::uint32 reExcites = 0;
+        juce::uint32 timerEnds = 0;
+        juce::uint32 silenceEnds = 0;
+        int voiceCap = 0;                       // PluckVoiceBudget's cap, 0 = adaptive voices off
+        juce::uint32 sheds = 0;
+
+        double worstNoteOnMicroseconds = 0.0;
+        double renderNanosPerVoiceSample = 0.0;
+        juce::uint32 droppedMidiEvents = 0;
+
+        std::array<float, 4> startupMilliseconds {};   // by StartupStep, 0 = hasn't happened
+    };
+
+    enum class StartupStep
+    {
+        voices,         // processor constructor: voices, voice bank, note tables
+        prepare,        // the last prepareToPlay
+        editor,         // editor constructor
+        secondPage      // second page controls, built the first time it's shown
+    };
+
+    //==============================================================================
+    // Any thread.
+
+    Snapshot getSnapshot() const
+    {
+        Snapshot s;
+        s.lastLoad = lastLoad.load(std::memory_order_relaxed);
+        s.peakLoad = peakLoad.load(std::memory_order_relaxed);
+
+        for (int i = 0; i < numLoadBuckets; ++i)
+            s.loadHistogram[(size_t) i] = loadHistogram[(size_t) i].load(std::memory_order_relaxed);
+
+        s.blocks = blocks.load(std::memory_order_relaxed);
+        s.overloads = s.loadHistogram[numLoadBuckets - 1];
+
+        s.activeVoices = activeVoices.load(std::memory_order_relaxed);
+        s.peakVoices = peakVoices.load(std::memory_order_relaxed);
+        s.steals = steals.load(std::memory_order_relaxed);
+        s.reExcites = reExcites.load(std::memory_order_relaxed);
+        s.timerEnds = timerEnds.load(std::memory_order_relaxed);
+        s.silenceEnds = silenceEnds.load(std::memory_order_relaxed);
+        s.voiceCap = voiceCap.load(std::memory_order_relaxed);
+        s.sheds = sheds.load(std::memory_order_relaxed);
+        s.droppedMidiEvents = droppedMidiEvents.load(std::memory_order_relaxed);
+
+        s.worstNoteOnMicroseconds = juce::Time::highResolutionTicksToSeconds(worstNoteOnTicks.load(std::memory_order_relaxed)) * 1.0e6;
+
+        const auto voiceSamples = renderVoiceSamples.load(std::memory_order_relaxed);
+        if (voiceSamples > 0)
+            s.renderNanosPerVoiceSample = juce::Time::highResolutionTicksToSeconds(renderTicks.load(std::memory_order_relaxed)) * 1.0e9
+                                            / (double) voiceSamples;
+
+        for (size_t i = 0; i < startupMilliseconds.size(); ++i)
+            s.startupMilliseconds[i] = startupMilliseconds[i].load(std::memory_order_relaxed);
+
+        return s;
+    }
+
+    void requestReset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+    // Whoever did the work, with the ticks from now() taken before it started.
+    void startupStepTook(StartupStep step, juce::int64 startTicks) noexcept
+    {
+        const double ms = juce::Time::highResolutionTicksToSeconds(now() - startTicks) * 1.0e3;
+        startupMilliseconds[(size_t) step].store((float) ms, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    // Audio thread only (or while it isn't running).
+
+    static juce::int64 now() noexcept { return juce::Time::getHighResolutionTicks(); }
+
+    void beginBlock() noexcept
+    {
+        if (resetRequested.exchange(false, std::memory_order_relaxed))
+            reset();
+    }
+
+    // Returns the block's load, for PluckVoiceBudget
+    float endBlock(juce::int64 startTicks, int numSamples, double sampleRate, int numActiveVoices, int adaptiveCap = 0) noexcept
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return 0.0f;
+
+        const double seconds = juce::Time::highResolutionTicksToSeconds(now() - startTicks);
+        const float load = (float) (seconds * sampleRate / (double) numSamples);
+
+        lastLoad.store(load, std::memory_order_relaxed);
+        if (load > peakLoad.load(std::memory_order_relaxed))
+            peakLoad.store(load, std::memory_order_relaxed);
+
+        const int bucket = juce::jlimit(0, numLoadBuckets - 1, (int) (load * 10.0f));
+        increment(loadHistogram[(size_t) bucket]);
+        increment(blocks);
+
+        activeVoices.store(numActiveVoices, std::memory_order_relaxed);
+        if (numActiveVoices > peakVoices.load(std::memory_order_relaxed))
+            peakVoices.store(numActiveVoices, std::memory_order_relaxed);
+
+        voiceCap.store(adaptiveCap, std::memory_order_relaxed);
+        return load;
+    }
+
+    void noteOnTook(juce::int64 ticks) noexcept
+    {
+        if (ticks > worstNoteOnTicks.load(std::memory_order_relaxed))
+            worstNoteOnTicks.store(ticks, std::memory_order_relaxed);
+    }
+
+    void voicesRendered(juce::int64 ticks, int numVoices, int numSamples) noexcept
+    {
+        renderTicks.store(renderTicks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+        renderVoiceSamples.store(renderVoiceSamples.load(std::memory_order_relaxed) + (juce::int64) numVoices * numSamples,
+                                 std::memory_order_relaxed);
+    }
+
+    void voiceStolen() noexcept      { increment(steals); }
+    void voiceReExcited() noexcept   { increment(reExcites); }
+    void voiceTimedOut() noexcept    { increment(timerEnds); }
+    void voiceWentSilent() noexcept  { increment(silenceEnds); }
+    void voiceShed() noexcept        { increment(sheds); }
+
+    void midiEventsDropped(juce::uint32 count) noexcept
+    {
+        if (count > 0)
+            droppedMidiEvents.store(droppedMidiEvents.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+    void reset() noexcept
+    {
+        lastLoad.store(0.0f, std::memory_order_relaxed);
+        peakLoad.store(0.0f, std::memory_order_relaxed);
+
+        for (auto& b : loadHistogram)
+            b.store(0, std::memory_order_relaxed);
+
+        for (auto* c : { &blocks, &steals, &reExcites, &timerEnds, &silenceEnds, &sheds, &droppedMidiEvents })
+            c->store(0, std::memory_order_relaxed);
+
+        activeVoices.store(0, std::memory_order_relaxed);
+        peakVoices.store(0, std::memory_order_relaxed);
+        voiceCap.store(0, std::memory_order_relaxed);
+        worstNoteOnTicks.store(0, std::memory_order_relaxed);
+        renderTicks.store(0, std::memory_order_relaxed);
+        renderVoiceSamples.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    // one writer, so no read-modify-write needed
+    static void increment(std::atomic<juce::uint32>& c) noexcept
+    {
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::atomic<float> lastLoad { 0.0f }, peakLoad { 0.0f };
+    std::array<std::atomic<juce::uint32>, numLoadBuckets> loadHistogram {};
+    std::atomic<juce::uint32> blocks { 0 };
+
+    std::atomic<int> activeVoices { 0 }, peakVoices { 0 };
+    std::atomic<juce::uint32> steals { 0 }, reExcites { 0 }, timerEnds { 0 }, silenceEnds { 0 };
+    std::atomic<int> voiceCap { 0 };
+    std::atomic<juce::uint32> sheds { 0 };
+    std::atomic<juce::uint32> droppedMidiEvents { 0 };
+
+    std::atomic<juce::int64> worstNoteOnTicks { 0 };
+    std::atomic<juce::int64> renderTicks { 0 }, renderVoiceSamples { 0 };
+
+    std::atomic<bool> resetRequested { false };
+
+    std::array<std::atomic<float>, 4> startupMilliseconds {};
+};
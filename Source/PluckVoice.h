@@ -1,99 +1,131 @@
 #pragma once
-class PluckVoice : public juce::SynthesiserVoice
+#include <JuceHeader.h>
+#include "TuningSystem.h"
+#include "PluckParameters.h"
+#include "PluckNoise.h"
+#include "PluckExciterBank.h"
+#include "PluckStringDelay.h"
+#include "PluckVoiceBank.h"
+#include "PluckVoiceArena.h"
+#include "PluckRamp.h"
+#include "PluckCoefficientTable.h"
+
+// One string pair, started and stopped by PluckSynth
+class PluckVoice
 {
 public:
-    PluckVoice(juce::AudioProcessorValueTreeState& params) 
-        : apvts(params)
+    // blockParams is the processor's per-block snapshot, read on note start / re-excite
+    PluckVoice(const PluckParameters& blockParams)
+        : params(blockParams)
     {
-        // Pre-allocate buffers to max size on construction to avoid reallocations during audio
-        leftDelayBuffer.resize(maxBufferSize, 0.0f);
-        rightDelayBuffer.resize(maxBufferSize, 0.0f);
-        
-        // PRE-ALLOCATE EXCITER BUFFERS TO MAX SIZE - THIS FIXES THE CRASH
-        exciterLeft.resize(maxBufferSize, 0.0f);
-        exciterRight.resize(maxBufferSize, 0.0f);
-        reExciterLeft.resize(maxBufferSize, 0.0f);
-        reExciterRight.resize(maxBufferSize, 0.0f);
-    }
-
-    bool canPlaySound(juce::SynthesiserSound* sound) override
-    {
-        return true;
+        // buffers come from the synth's PluckVoiceArena, see setVoiceMemory()
+        pitchBend.snapTo(1.0f);
     }
 
     bool isPlayingNote() const { return hasStartedNote; }
+
+    // reference loop: why the last fade started, for PluckTelemetry
+    bool endedOnTimer() const { return hot.timerFade; }
+    bool endedOnSilence() const { return hot.silenceFade; }
+    bool isFadingOut() const { return hot.fadeOut; }
+
+    // reference loop: mean square per output over the last energy window, see trackEnergy()
+    float getLevel() const { return level; }
     int getCurrentlyPlayingNote() const { return currentMidiNote; }
 
-    void startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound*, int) override
+    // bendSemitones and pressure: where the note's channel already is (see PluckSynth)
+    void startNote(int midiNoteNumber, float velocity, float bendSemitones = 0.0f, float notePressure = 0.0f)
     {
         currentMidiNote = midiNoteNumber;
+        pitchBend.snapTo(getBendFactor(bendSemitones));
+        pressure = juce::jlimit(0.0f, 1.0f, notePressure);
         
         // these need to be considered global for the lifetime of the voice
-        setFineTuneCents(apvts.getRawParameterValue("FINETUNE")->load());
-        setCurrentDecay(apvts.getRawParameterValue("DECAY")->load());
-        setCurrentDamp(apvts.getRawParameterValue("DAMP")->load());
-        setCurrentColor(apvts.getRawParameterValue("COLOR")->load());
-        setStereoEnabled(apvts.getRawParameterValue("STEREO")->load());
-        setStereoMicrotuneCents(apvts.getRawParameterValue("STEREOMICROTUNECENTS")->load());
-        currentVelocity = velocity; 
+        // (idle voices don't get per-block pushes, so take the whole snapshot here)
+        applyParameters(params, PluckParameters::allFields);
+        hot.currentVelocity = velocity; 
+
+        // STEREO off: one string for both outputs, kept until the note ends so a
+        // switch mid-note never changes what a ringing string sounds like
+        monoString = ! stereoEnabled;
         
         smoothedDelayLengthL.reset(currentSampleRate, 0.2);
         smoothedDelayLengthR.reset(currentSampleRate, 0.2);
-        initializeDelayLineAndParameters(midiNoteNumber, currentVelocity);
+        initializeDelayLineAndParameters(midiNoteNumber, hot.currentVelocity);
         smoothedDelayLengthL.setCurrentAndTargetValue(baseExactDelayFracL);
         smoothedDelayLengthR.setCurrentAndTargetValue(baseExactDelayFracR);      
+        updateLoopTargets(0);
 
         hasStartedNote = true;
-        reExciterIndexL = -1;
-        reExciterIndexR = -1;
-
-
+        hot.reExciteRemaining = 0;
+        hot.pendingReExciteSample = -1; // one scheduled for the note this voice was stolen from
+        hot.silenceFade = false;
+        hot.timerFade = false;
+        hot.shedFade = false;
+        resetEnergy();
+        level = PluckVoiceBank::unmeasuredLevel;
+
+        if (usesVoiceBank())
+        {
+            voiceBank->startVoice(bankVoiceIndex, hot.exciterReadL, hot.exciterReadR, monoString);
+            syncVoiceBank();
+        }
     }
 
-    void stopNote(float, bool allowTailOff) override
+    void stopNote(float, bool allowTailOff)
     {
-        if (gateEnabled && allowTailOff)
+        // a voice already being shed keeps its short fade
+        if (gateEnabled && allowTailOff && ! hot.shedFade)
         {
-            fadeOut = true;
-            fadeCounter = 0;
-            gateDampingSamples = static_cast<int>(currentSampleRate * apvts.getRawParameterValue("GATEDAMPING")->load());
+            hot.fadeOut = true;
+            hot.fadeCounter = 0;
+            hot.silenceFade = false;
+            hot.timerFade = false;
+            hot.shedFade = false;
+
+            if (usesVoiceBank())
+                voiceBank->beginFade(bankVoiceIndex);
         }
         // Remove the else clause - let notes decay naturally when gate is disabled
     }
 
-    void setDelayTimes()
+    // The adaptive voice cap (PluckVoiceBudget) wants this voice gone: a short fade,
+    // gate or not, long enough not to click
+    void shed()
     {
-        float stereoMicrotuneCached;
-
-        if (stereoEnabled){
-            stereoMicrotuneCached = stereoMicrotune;
-        }
-        else
-        {
-            stereoMicrotuneCached = 0.0f;
-        }
+        hot.fadeOut = true;
+        hot.fadeCounter = 0;
+        hot.silenceFade = false;
+        hot.timerFade = false;
+        hot.shedFade = true;
+
+        if (usesVoiceBank())
+            voiceBank->shedVoice(bankVoiceIndex, getShedFadeSamples());
+    }
 
-        // Get tuning system deviation for this note
-        float tuningDeviation = 0.0f;
-        if (tuningSystem != nullptr)
-        {
-            tuningDeviation = tuningSystem->getCentDeviationForNote(currentMidiNote);
-        }
+    // setDelayTimes() jumps the smoothers, glide from where they were instead
+    void glideToDelayTimes()
+    {
+        const float fromL = smoothedDelayLengthL.getCurrentValue();
+        const float fromR = smoothedDelayLengthR.getCurrentValue();
 
-        // Combine fine tune, stereo microtune, and tuning system deviation
-        float totalCentsL = currentFineTuneCents - stereoMicrotuneCached + tuningDeviation;
-        float totalCentsR = currentFineTuneCents + stereoMicrotuneCached + tuningDeviation;
+        setDelayTimes();
 
-        currentFineTuneMultiplierL = std::pow(2.0f, totalCentsL / 1200.0f);
-        currentFineTuneMultiplierR = std::pow(2.0f, totalCentsR / 1200.0f);
+        // Update smoothing targets (do NOT reset smoother)
+        smoothedDelayLengthL.setCurrentAndTargetValue(fromL);
+        smoothedDelayLengthR.setCurrentAndTargetValue(fromR);
+        smoothedDelayLengthL.setTargetValue(baseExactDelayFracL);
+        smoothedDelayLengthR.setTargetValue(baseExactDelayFracR);
+    }
 
+    void setDelayTimes()
+    {
         if (currentMidiNote >= 0 && currentSampleRate > 0.0)
         {
-            const auto freq = juce::MidiMessage::getMidiNoteInHertz(currentMidiNote);
-            const float exactDelay = currentSampleRate / freq;
-
-            baseExactDelayFracL = exactDelay / currentFineTuneMultiplierL;
-            baseExactDelayFracR = exactDelay / currentFineTuneMultiplierR;
+            // the tuning's period for this note times the fine tune / microtune scales; shared
+            // with the exciter bank so its tables line up with these delays exactly
+            PluckExciterBank::computeDelays(tuningSystem, currentMidiNote, currentSampleRate, delayScaleL, delayScaleR,
+                                            baseExactDelayFracL, baseExactDelayFracR);
 
             // ADD SAFETY BOUNDS CHECK
             baseExactDelayIntL = static_cast<int>(std::round(baseExactDelayFracL));
@@ -110,43 +142,35 @@ public:
     {
         hasStartedNote = false;
         currentMidiNote = -1;
-        juce::SynthesiserVoice::clearCurrentNote();
-    }
+        hot.pendingReExciteSample = -1;
 
-    void pitchWheelMoved(int) override {}
-    void controllerMoved(int, int) override {}
+        if (voiceBank != nullptr)
+            voiceBank->releaseVoice(bankVoiceIndex);
+
+        releaseExciter();
+    }
 
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Lagrange3rd>& getLeftDelayLine() { return leftDelayLine; }
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Lagrange3rd>& getRightDelayLine() { return rightDelayLine; }
+    PluckStringDelay& getLeftDelayLine() { return leftDelayLine; }
+    PluckStringDelay& getRightDelayLine() { return rightDelayLine; }
     juce::LinearSmoothedValue<float>& getSmoothedDelayL() { return smoothedDelayLengthL; }
     juce::LinearSmoothedValue<float>& getSmoothedDelayR() { return smoothedDelayLengthR; }
 
     static constexpr int getMaxBufferSize() { return maxBufferSize; }
 
     // ============================== RE EXCITER ====================================
-    void setReExciterIndexL(int indexL) { reExciterIndexL = indexL; }
-    void setReExciterIndexR(int indexR) { reExciterIndexR = indexR; }
-    std::vector<float>& getReExciterLeft() { return reExciterLeft; }
-    std::vector<float>& getReExciterRight() { return reExciterRight; }
-
     void scheduleReExcite(int sampleOffset, float velocity)
     {
-        pendingReExciteSample = sampleOffset;
+        hot.pendingReExciteSample = sampleOffset;
         pendingReExciteVelocity = velocity;
     }
 
     void reExcite()
     {
-        setFineTuneCents(apvts.getRawParameterValue("FINETUNE")->load());
-        setCurrentDecay(apvts.getRawParameterValue("DECAY")->load());
-        setCurrentDamp(apvts.getRawParameterValue("DAMP")->load());
-        setCurrentColor(apvts.getRawParameterValue("COLOR")->load());
-        setStereoEnabled(apvts.getRawParameterValue("STEREO")->load());
-        setStereoMicrotuneCents(apvts.getRawParameterValue("STEREOMICROTUNECENTS")->load());
+        applyParameters(params, PluckParameters::allFields);
 
         setDelayTimes();
         
-        generateExciter(pendingReExciteVelocity, exciterLeft, exciterRight);
+        prepareExciter(pendingReExciteVelocity);
         
         smoothedDelayLengthL.reset(currentSampleRate, 0.2); // less glitchy reaction to finetune
         smoothedDelayLengthR.reset(currentSampleRate, 0.2); // less glitchy reaction to finetune
@@ -154,174 +178,347 @@ public:
         smoothedDelayLengthR.setCurrentAndTargetValue(baseExactDelayFracR);
 
 		// CRITICAL: Reset note timer and fade state for clean retrigger
-		activeSampleCounter = 0;
-		fadeOut = false;
-		fadeCounter = 0;
+		hot.activeSampleCounter = 0;
+		hot.fadeOut = false;
+		hot.fadeCounter = 0;
+		hot.silenceFade = false;
+		hot.timerFade = false;
+		hot.shedFade = false;
+		resetEnergy();
+		level = PluckVoiceBank::unmeasuredLevel;
+
+        // no timer cutoff for one period, same guard the voice bank uses
+        hot.reExciteRemaining = juce::jmax(baseExactDelayIntL, baseExactDelayIntR);
+
+        if (usesVoiceBank())
+        {
+            voiceBank->reExciteVoice(bankVoiceIndex, hot.reExciteRemaining);
+            voiceBank->setVoiceExciter(bankVoiceIndex, hot.exciterReadL, hot.exciterReadR);
+            syncVoiceBank();
+        }
+    }
 
-        reExciterIndexL = 0;
-        reExciterIndexR = 0;
+    // ============================== VOICE BANK ====================================
+    // In voice bank mode the strings live in PluckVoiceBank and this voice only
+    // drives them: note events go straight in, settings are pushed per block.
+    void setVoiceBank(PluckVoiceBank* bank, int index)
+    {
+        voiceBank = bank;
+        bankVoiceIndex = index;
+    }
+
+    bool usesVoiceBank() const { return voiceBank != nullptr && voiceBank->isEnabled(); }
+    int getBankVoiceIndex() const { return bankVoiceIndex; }
+
+    void syncVoiceBank()
+    {
+        PluckVoiceBank::VoiceSettings settings;
+        settings.delayL = smoothedDelayLengthL.getCurrentValue();
+        settings.delayR = smoothedDelayLengthR.getCurrentValue();
+        settings.bend = pitchBend.value;
+        settings.bendTarget = pitchBend.target;
+        settings.bendSamples = pitchBend.getRemainingSamples();
+        settings.feedbackGain = loopRamps.feedback.target;
+        settings.damping = loopRamps.damping.target;
+        settings.curveAmount = loopRamps.curve.target;
+        settings.rampSamples = PluckRamp::getRampSamples(currentSampleRate);
+        settings.velocity = hot.currentVelocity;
+        settings.fadeSamples = static_cast<int>(currentSampleRate * gateDampingSeconds);
+        settings.maxSamplesAllowed = hot.maxSamplesAllowed;
+        settings.exciterLengthL = hot.currentExciterSizeL + 1;
+        settings.exciterLengthR = hot.currentExciterSizeR + 1;
+        settings.interpolation = leftDelayLine.getInterpolation();
+        settings.silenceFloor = params.noteTimer ? 0.0f : juce::square(juce::Decibels::decibelsToGain(params.silenceFloorDb, -200.0f));
+        settings.energyWindow = juce::jmax(baseExactDelayIntL, baseExactDelayIntR);
+
+        voiceBank->syncVoice(bankVoiceIndex, settings);
+    }
+
+    // ============================== VOICE MEMORY ====================================
+    // Strings 2 * index and 2 * index + 1 of the arena, plus this voice's exciters.
+    // prepareToPlay only, the arena may have been reallocated.
+    void setVoiceMemory(const PluckVoiceArena& arena, int index)
+    {
+        leftDelayLine.setBuffer(arena.getStringRing(2 * index), arena.getRingSize());
+        rightDelayLine.setBuffer(arena.getStringRing(2 * index + 1), arena.getRingSize());
+
+        exciterLeft = arena.getExciter(index, 0);
+        exciterRight = arena.getExciter(index, 1);
+        exciterCapacity = arena.getExciterSize();
+
+        releaseExciter();
+    }
+
+    // ============================== EXCITER BANK ====================================
+    // shared precomputed exciters; without one (or on a miss) the voice renders its own
+    void setExciterBank(PluckExciterBank* bank)
+    {
+        releaseExciter();
+        exciterBank = bank;
+    }
+
+    // Per-note feedback, damping and note timer, shared by all voices. Optional, without
+    // one the voice works them out itself.
+    void setCoefficientTable(const PluckCoefficientTable* table)
+    {
+        coefficientTable = table;
     }
 
-    void setCurrentPlaybackSampleRate(double newRate) override
+    // ============================== NOISE ====================================
+    // each voice has its own exciter noise stream, keyed by (seed, stream)
+    void setNoiseStream(int stream)
+    {
+        noiseStream = static_cast<juce::uint32>(stream);
+        resetNoise();
+    }
+
+    // back to the start of the stream for the current seed, so renders repeat exactly
+    void resetNoise()
+    {
+        noiseSeed = params.noiseSeed;
+        noise.setKey(noiseSeed, noiseStream);
+        exciterVariant = 0;
+    }
+
+    // the bank splits its block here so re-excites stay sample accurate
+    int getPendingReExciteSample() const { return hot.pendingReExciteSample; }
+
+    // A fine tune change glides the delay. The read position moves every
+    // controlBlockSize samples while it does, in both engines.
+    static constexpr int controlBlockSize = 32;
+
+    bool isDelayGliding() const { return smoothedDelayLengthL.isSmoothing() || smoothedDelayLengthR.isSmoothing(); }
+
+    // voice bank mode: the bank rendered numSamples on the current delay (and bend)
+    void advanceDelayGlide(int numSamples)
+    {
+        smoothedDelayLengthL.skip(numSamples);
+        smoothedDelayLengthR.skip(numSamples);
+        pitchBend.skip(numSamples);
+    }
+
+    // ============================== PITCH BEND / PRESSURE ====================================
+    // Pitch bend scales the string delays. A new bend glides over bendRampSeconds,
+    // and while it does both engines read the strings at a new delay every sample.
+    static constexpr double bendRampSeconds = 0.005;
+
+    static float getBendFactor(float semitones) { return std::exp2(-semitones / 12.0f); }
+
+    void setPitchBend(float semitones)
+    {
+        pitchBend.setTarget(getBendFactor(semitones), juce::jmax(1, juce::roundToInt(currentSampleRate * bendRampSeconds)));
+    }
+
+    bool isPitchBending() const { return pitchBend.isRamping(); }
+
+    // Channel or poly pressure, 0..1: holds the string by taking the loop gain part of
+    // the way to its ceiling. Ramps like any other loop parameter.
+    void setPressure(float newPressure)
+    {
+        newPressure = juce::jlimit(0.0f, 1.0f, newPressure);
+
+        if (newPressure != pressure)
+        {
+            pressure = newPressure;
+            updateLoopTargets(PluckRamp::getRampSamples(currentSampleRate));
+        }
+    }
+
+    void applyPendingReExcite()
+    {
+        reExcite();
+        hot.pendingReExciteSample = -1;
+    }
+
+    void setCurrentPlaybackSampleRate(double newRate)
     {
         currentSampleRate = newRate;
-        juce::dsp::ProcessSpec spec;
-        spec.sampleRate = newRate;
-        spec.maximumBlockSize = maxBlockSize;
-        spec.numChannels = 1;
-        leftDelayLine.prepare(spec);
-        rightDelayLine.prepare(spec);
     }
 
     // =============================== DSP LOOP ===============================
-    void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override
+    // The block is cut into spans inside which nothing changes state: a pending re-excite,
+    // the end of each side's exciter injection, the note timer cutting in and the end of a
+    // fade all fall on span edges. Each span then runs a kernel compiled for exactly its
+    // case, picked from a table (getSpanKernels()), without any of those tests.
+    void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
     {
-        if (baseExactDelayIntL < 1 || baseExactDelayIntR < 1 || !hasStartedNote)
+        if (baseExactDelayIntL < 1 || baseExactDelayIntR < 1 || !hasStartedNote || exciterLeft == nullptr)
+            return;
+
+        if (isDelayGliding() && numSamples > controlBlockSize)
+        {
+            for (int done = 0; done < numSamples && hasStartedNote; done += controlBlockSize)
+                renderNextBlock(outputBuffer, startSample + done, juce::jmin(controlBlockSize, numSamples - done));
+
             return;
+        }
 
         juce::ScopedNoDenormals noDenormals;
 
-        const float targetAmplitude = 0.001f;
+        // GATEDAMPING fadeout time, if 0 use the original 64 samples as fallback
+        int fadeoutSamples = static_cast<int>(currentSampleRate * gateDampingSeconds);
+        if (fadeoutSamples <= 0)
+            fadeoutSamples = 64;
 
-        // 1.5f multiplier is used to try and match the expected decay time at a reasonable note range
-        float feedbackGain = std::pow(targetAmplitude, 1.0f / (1.5f * currentDecay * cyclesPerSecondL));
-        feedbackGain = juce::jlimit(0.0f, 0.999f, feedbackGain);
+        // silent voices only need to avoid a click
+        if (hot.silenceFade)
+            fadeoutSamples = silenceFadeSamples;
+        else if (hot.shedFade)
+            fadeoutSamples = getShedFadeSamples();
 
-        auto* outL = outputBuffer.getWritePointer(0, startSample);
-        auto* outR = (outputBuffer.getNumChannels() >= 2) ? outputBuffer.getWritePointer(1, startSample) : outL;
+        Span span;
+        span.outL = outputBuffer.getWritePointer(0, startSample);
+        span.outR = (outputBuffer.getNumChannels() >= 2) ? outputBuffer.getWritePointer(1, startSample) : span.outL;
+        span.inverseFadeSamples = 1.0f / (float) fadeoutSamples;
 
-        float currentDelayValueL = smoothedDelayLengthL.getCurrentValue();
-        float currentDelayValueR = smoothedDelayLengthR.getCurrentValue();
+        // feedback, damping and curve step towards their targets every sample
+        span.ramps = loopRamps;
+
+        span.delayValueL = smoothedDelayLengthL.getCurrentValue();
+        span.delayValueR = smoothedDelayLengthR.getCurrentValue();
+
+        // a moving pitch bend reads at a new delay every sample, the rings get room for all of it first
+        span.bend = pitchBend;
+        const bool bending = span.bend.isRamping();
+
+        if (bending)
+        {
+            leftDelayLine.reserve(span.delayValueL * span.bend.high);
+
+            if (! monoString)
+                rightDelayLine.reserve(span.delayValueR * span.bend.high);
+        }
 
         // my delay calc is robust enough to not require jlimiting it. otherwise fix it there.
-        // constexpr float minDelayTime = 0.01f; // or smaller, but > 0 -- VERY unlikely, probably impossible.
-        // float clampedDelay = std::max(minDelayTime, currentDelayValue); // my lowest note won't hit max buffer size.
-        leftDelayLine.setDelay(currentDelayValueL);
-        rightDelayLine.setDelay(currentDelayValueR);
+        leftDelayLine.setDelay(span.delayValueL * span.bend.value);
+
+        if (! monoString)
+            rightDelayLine.setDelay(span.delayValueR * span.bend.value);
+
+        // ring pointers, masks and read weights stay in registers for the whole loop
+        span.delayL = leftDelayLine.beginBlock();
+        span.delayR = monoString ? span.delayL : rightDelayLine.beginBlock();
 
-        for (int i = 0; i < numSamples; ++i)
+        // exciter injection runs while the sample counter is below both the delay and the exciter's length
+        const int delayCeilL = static_cast<int>(std::ceil(span.delayValueL));
+        const int delayCeilR = static_cast<int>(std::ceil(span.delayValueR));
+
+        // the four kernels for this block's interpolation, motion and string count
+        const SpanKernels* kernels = &getSpanKernels(span, bending);
+
+        for (int i = 0; i < numSamples;)
         {
-            if (pendingReExciteSample == (startSample + i))
+            if (hot.pendingReExciteSample == (startSample + i))
             {
+                loopRamps = span.ramps;
                 reExcite();
-                pendingReExciteSample = -1;
-            }
+                span.ramps = loopRamps;
+                hot.pendingReExciteSample = -1;
 
-            float delayedSampleL = leftDelayLine.popSample(0);
-            float delayedSampleR = rightDelayLine.popSample(0);
-
-            float dampingAmount;
-            dampingAmount = juce::jmap(currentDamp, 0.0f, 1.0f, 0.99f, 0.01f);
-
-            // simple damping
-            // filteredSampleL = previousSampleL + dampingAmount * (delayedSampleL - previousSampleL);
-            // filteredSampleR = previousSampleR + dampingAmount * (delayedSampleR - previousSampleR);
-
-            // TESTING damping curve
-            float highFreqContent = std::abs(delayedSampleL - previousSampleL);
-            // Apply frequency-dependent damping
-            float adaptiveDamping = dampingAmount;
-            if (currentDampingCurve > 0.5f) {
-                // More damping for high frequencies (brighter transient, duller sustain)
-                float hfBoost = (currentDampingCurve - 0.5f) * 2.0f; // 0-1 range
-                adaptiveDamping = dampingAmount * (1.0f + hfBoost * highFreqContent * 0.5f);
-            } else {
-                // Less damping for high frequencies (maintains brightness longer)
-                float hfReduction = (0.5f - currentDampingCurve) * 2.0f; // 0-1 range
-                adaptiveDamping = dampingAmount * (1.0f - hfReduction * highFreqContent * 0.3f);
+                // the new pluck's parameters can set the ramps moving
+                kernels = &getSpanKernels(span, bending);
             }
-            adaptiveDamping = juce::jlimit(0.01f, 0.99f, adaptiveDamping);
-            filteredSampleL = previousSampleL + adaptiveDamping * (delayedSampleL - previousSampleL);
-            filteredSampleR = previousSampleR + adaptiveDamping * (delayedSampleR - previousSampleR);
 
-            float addL = 0.0f;
-            float addR = 0.0f;
+            int end = numSamples;
 
-            // optionally, set minimum velo
-            // float mappedValue = minimumExciterVelocity + velocity * (1.0f - minimumExciterVelocity);
+            const int pending = hot.pendingReExciteSample - startSample;
+            if (pending > i && pending < end)
+                end = pending;
 
-            // SAFE ACCESS TO EXCITER BUFFERS
-            // inject exciter(s) into the delayline
-            if (activeSampleCounter < currentDelayValueL && activeSampleCounter <= currentExciterSizeL)
-            {
-                addL += exciterLeft[activeSampleCounter] * currentVelocity;
-            }
-            if (activeSampleCounter < currentDelayValueR && activeSampleCounter <= currentExciterSizeR)
-            {
-                addR += exciterRight[activeSampleCounter] * currentVelocity;
-            }
-            if (reExciterIndexL >= 0 && reExciterIndexL < baseExactDelayIntL && reExciterIndexL < currentExciterSizeL)
-            {
-                addL += reExciterLeft[reExciterIndexL] * currentVelocity;
-                ++reExciterIndexL;
-                if (reExciterIndexL >= baseExactDelayIntL)
-                    reExciterIndexL = -1;
-            }
-            if (reExciterIndexR >= 0 && reExciterIndexR < baseExactDelayIntR && reExciterIndexR < currentExciterSizeR)
-            {
-                addR += reExciterRight[reExciterIndexR] * currentVelocity;
-                ++reExciterIndexR;
-                if (reExciterIndexR >= baseExactDelayIntR)
-                    reExciterIndexR = -1;
-            }
+            const int counter = hot.activeSampleCounter;
+            const int injectL = juce::jmin(delayCeilL, hot.currentExciterSizeL + 1) - counter;
+            const int injectR = juce::jmin(delayCeilR, hot.currentExciterSizeR + 1) - counter;
 
-            filteredSampleL += addL;
-            filteredSampleR += addR;
+            if (injectL > 0) end = juce::jmin(end, i + injectL);
+            if (injectR > 0) end = juce::jmin(end, i + injectR);
 
-			// NEW GUARDED CODE:
-			if (!fadeOut && 
-				activeSampleCounter >= maxSamplesAllowed && 
-				reExciterIndexL < 0 && reExciterIndexR < 0)  // Guard: skip timer cutoff during re-excitation
-			{
-				fadeOut = true;
-				fadeCounter = 0;
-			}
+            // the note timer cuts in once the counter passes maxSamplesAllowed and the re-excite guard has run out
+            if (! hot.fadeOut)
+            {
+                const int untilTimer = juce::jmax(hot.maxSamplesAllowed - counter, hot.reExciteRemaining - 1, 0);
 
+                if (untilTimer == 0)
+                {
+                    hot.fadeOut = true;
+                    hot.fadeCounter = 0;
+                    hot.timerFade = true;
+                }
+                else if (untilTimer < end - i)
+                {
+                    end = i + untilTimer;
+                }
+            }
 
-            if (fadeOut)
+            // the sample that takes the fade to zero ends the voice instead of playing
+            if (hot.fadeOut)
             {
-                fadeCounter++;
-                
-                // Use the existing GATEDAMPING parameter for fadeout time
-                float fadeoutTime = apvts.getRawParameterValue("GATEDAMPING")->load();
-                int fadeoutSamples = static_cast<int>(currentSampleRate * fadeoutTime);
-                
-                // If fadeout time is 0, use the original 64 samples as fallback
-                if (fadeoutSamples <= 0)
-                    fadeoutSamples = 64;
-                
-                float fadeMultiplier = std::max(0.0f, 1.0f - (float)fadeCounter / (float)fadeoutSamples);
-                filteredSampleL *= fadeMultiplier;
-                filteredSampleR *= fadeMultiplier;
-                
-                if (fadeMultiplier <= 0.0f)
+                const int untilSilent = fadeoutSamples - 1 - hot.fadeCounter;
+
+                if (untilSilent <= 0)
                 {
+                    endBlock(span);
                     clearCurrentNote();
                     return;
                 }
+
+                end = juce::jmin(end, i + untilSilent);
             }
 
-            if (!std::isfinite(filteredSampleL)) filteredSampleL = 0.0f;
-            if (!std::isfinite(filteredSampleR)) filteredSampleR = 0.0f;
+            // the side that isn't injecting reads a zero, without stepping through it
+            span.exciterL = injectL > 0 ? hot.exciterReadL + counter : &silence;
+            span.exciterR = injectR > 0 ? hot.exciterReadR + counter : &silence;
+            span.exciterStepL = injectL > 0 ? 1 : 0;
+            span.exciterStepR = injectR > 0 ? 1 : 0;
 
-            float outputL = filteredSampleL * feedbackGain;
-            float outputR = filteredSampleR * feedbackGain;
+            const bool exciting = injectL > 0 || injectR > 0;
+            const auto kernel = (*kernels)[(exciting ? 2 : 0) + (hot.fadeOut ? 1 : 0)];
+            (this->*kernel)(span, i, end);
 
-            leftDelayLine.pushSample(0, outputL);
-            rightDelayLine.pushSample(0, outputR);
+            const int spanLength = end - i;
+            hot.activeSampleCounter = juce::jmin(counter, std::numeric_limits<int>::max() - spanLength) + spanLength;
+            hot.reExciteRemaining = juce::jmax(0, hot.reExciteRemaining - spanLength);
 
-            previousSampleL = outputL;
-            previousSampleR = outputR;
+            i = end;
+        }
 
-            outL[i] += outputL;
-            outR[i] += outputR;
+        endBlock(span);
 
-            ++activeSampleCounter;
-        }
+        loopRamps = span.ramps;
+        smoothedDelayLengthL.skip(numSamples);
+        smoothedDelayLengthR.skip(numSamples);
+        pitchBend = span.bend;
+
+        trackEnergy(span.energy, numSamples);
     }
 
     // ====================== PARAMETER SETTERS ==============================================
 
+    // Pushes the snapshot fields flagged in 'changed'. Same order the old per-block setter loop used.
+    void applyParameters(const PluckParameters& p, juce::uint32 changed)
+    {
+        // fine tune and microtune reach the delays as scales, worked out once per block
+        if (changed & (PluckParameters::fineTuneField | PluckParameters::stereoMicrotuneField | PluckParameters::stereoField))
+        {
+            delayScaleL = p.delayScaleL;
+            delayScaleR = p.delayScaleR;
+        }
+
+        if (changed & PluckParameters::gateField)            setGateEnabled(p.gateEnabled);
+        if (changed & PluckParameters::stereoField)          setStereoEnabled(p.stereoEnabled);
+        if (changed & PluckParameters::fineTuneField)        setFineTuneCents(p.fineTuneCents);
+        if (changed & PluckParameters::decayField)           setCurrentDecay(p.decay);
+        if (changed & PluckParameters::dampField)            setCurrentDamp(p.damp);
+        if (changed & PluckParameters::colorField)           setCurrentColor(p.color);
+        if (changed & PluckParameters::stereoMicrotuneField) setStereoMicrotuneCents(p.stereoMicrotuneCents);
+        if (changed & PluckParameters::exciterSlewRateField) setExciterSlewRate(p.exciterSlewRate);
+        if (changed & PluckParameters::dampingCurveField)    setDampingCurve(p.dampingCurve);
+        if (changed & PluckParameters::gateDampingField)     gateDampingSeconds = p.gateDampingSeconds;
+
+        if (changed & (PluckParameters::decayField | PluckParameters::dampField | PluckParameters::dampingCurveField))
+            updateLoopTargets(PluckRamp::getRampSamples(currentSampleRate));
+    }
+
+
     void setFineTuneCents(float newFineTuneCents)
     {
         if (newFineTuneCents != currentFineTuneCents)
@@ -329,14 +526,18 @@ public:
             currentFineTuneCents = newFineTuneCents;
 
             // Recalculate delay times based on new finetune
-            setDelayTimes();
-
-            // Update smoothing targets (do NOT reset smoother)
-            smoothedDelayLengthL.setTargetValue(baseExactDelayFracL);
-            smoothedDelayLengthR.setTargetValue(baseExactDelayFracR);
+            glideToDelayTimes();
         }
     }
 
+    // A new tuning went live (TuningSystem::beginBlock()): a playing note glides over
+    // to its new pitch like it would for fine tune.
+    void retune()
+    {
+        if (hasStartedNote)
+            glideToDelayTimes();
+    }
+
     void setTuningSystem(const TuningSystem* tuning) 
     { 
         tuningSystem = tuning; 
@@ -362,13 +563,9 @@ public:
         gateEnabled = enabled;
     }
 
-    void setStereoEnabled(bool enabled) {
-        if (stereoEnabled != enabled) {
-            stereoEnabled = enabled;
-            std::fill(leftDelayBuffer.begin(), leftDelayBuffer.end(), 0.f);
-            std::fill(rightDelayBuffer.begin(), rightDelayBuffer.end(), 0.f);
-            bufferIndex = 0;
-        }
+    void setStereoEnabled(bool enabled)
+    {
+        stereoEnabled = enabled;
     }
 
     void setStereoMicrotuneCents(float newStereoMicrotuneCents)
@@ -391,159 +588,449 @@ public:
         currentDampingCurve = newDampingCurve;
     }
 
+    // The exciters aren't cleared, the next note writes every sample it reads.
     void resetBuffers()
     {
-        std::fill(leftDelayBuffer.begin(), leftDelayBuffer.end(), 0.0f);
-        std::fill(rightDelayBuffer.begin(), rightDelayBuffer.end(), 0.0f);
-        
-        // CLEAR EXCITER BUFFERS SAFELY
-        std::fill(exciterLeft.begin(), exciterLeft.end(), 0.0f);
-        std::fill(exciterRight.begin(), exciterRight.end(), 0.0f);
-        std::fill(reExciterLeft.begin(), reExciterLeft.end(), 0.0f);
-        std::fill(reExciterRight.begin(), reExciterRight.end(), 0.0f);
-        
-        bufferIndex = 0;
-        previousSampleL = 0.0f;
-        previousSampleR = 0.0f;
-        fadeOut = false;
-        fadeCounter = 0;
-        activeSampleCounter = 0;
+        hot.previousSampleL = 0.0f;
+        hot.previousSampleR = 0.0f;
+        hot.fadeOut = false;
+        hot.fadeCounter = 0;
+        hot.activeSampleCounter = 0;
         currentMidiNote = -1;
         hasStartedNote = false;
         leftDelayLine.reset();
         rightDelayLine.reset();
-        reExciterIndexL = -1;
-        reExciterIndexR = -1;
+        hot.reExciteRemaining = 0;
+        hot.pendingReExciteSample = -1;
+
+        if (voiceBank != nullptr)
+            voiceBank->releaseVoice(bankVoiceIndex);
+
+        releaseExciter();
     }
 
 private:
+    // the processor's table, once it has been built for this block's parameters
+    bool hasCoefficientTable() const { return coefficientTable != nullptr && coefficientTable->isBuilt(); }
+
+    // Where the per-sample loop coefficients are heading, 0 samples jumps (new note)
+    void updateLoopTargets(int rampSamples)
+    {
+        if (hasCoefficientTable())
+        {
+            loopRamps.feedback.setTarget(applyPressure(coefficientTable->getFeedbackGain(currentMidiNote)), rampSamples);
+            loopRamps.damping.setTarget(coefficientTable->getDamping(), rampSamples);
+            loopRamps.curve.setTarget(coefficientTable->getCurveAmount(), rampSamples);
+            return;
+        }
+
+        loopRamps.feedback.setTarget(applyPressure(PluckCoefficientTable::computeFeedbackGain(currentDecay, cyclesPerSecondL)), rampSamples);
+        loopRamps.damping.setTarget(PluckCoefficientTable::computeDamping(currentDamp), rampSamples);
+        loopRamps.curve.setTarget(PluckVoiceBank::getCurveAmount(currentDampingCurve), rampSamples);
+    }
+
+    float applyPressure(float feedbackGain) const
+    {
+        return pressure > 0.0f ? feedbackGain + (maxFeedbackGain - feedbackGain) * pressureSustain * pressure
+                               : feedbackGain;
+    }
+
     void initializeDelayLineAndParameters(int midiNoteNumber, float velocity)
     {
         setDelayTimes();
-        cyclesPerSecondL = currentSampleRate / baseExactDelayFracL;
-        cyclesPerSecondR = currentSampleRate / baseExactDelayFracR;
-        bufferIndex = 0;
+        // the feedback's frequency, without fine tune (see PluckCoefficientTable)
+        cyclesPerSecondL = PluckCoefficientTable::getCyclesPerSecond(tuningSystem, currentMidiNote, currentSampleRate);
+        cyclesPerSecondR = cyclesPerSecondL;
 
-        generateExciter(velocity, exciterLeft, exciterRight);
+        prepareExciter(velocity);
 
-        leftDelayLine.reset();
-        rightDelayLine.reset();
-        leftDelayLine.setDelay(0);
-        rightDelayLine.setDelay(0);
+        // rings sized to this note's period
+        const auto interpolation = static_cast<PluckStringDelay::Interpolation>(params.stringInterpolation);
+        leftDelayLine.setInterpolation(interpolation);
+        rightDelayLine.setInterpolation(interpolation);
+        leftDelayLine.reset(baseExactDelayFracL);
+
+        if (! monoString)
+            rightDelayLine.reset(baseExactDelayFracR);
 
-        fadeOut = false;
-        fadeCounter = 0;
-        previousSampleL = 0.0f;
-        previousSampleR = 0.0f;
+        hot.fadeOut = false;
+        hot.fadeCounter = 0;
+        hot.previousSampleL = 0.0f;
+        hot.previousSampleR = 0.0f;
     }
 
-    // FIXED EXCITER GENERATOR - NO MORE DYNAMIC RESIZING
-    void generateExciter(float currentVelocity, std::vector<float>& exciterL, std::vector<float>& exciterR)
+    // Points exciterReadL/R at a shared table from the exciter bank, or renders the
+    // same table into this voice's own exciter when the bank has nothing matching yet
+    void prepareExciter(float velocity)
     {
-        // NO MORE RESIZE! Buffers are pre-allocated to maxBufferSize
-        // Just clear the portion we'll use
-        int safeDelayIntL = juce::jlimit(1, maxBufferSize - 1, baseExactDelayIntL);
-        int safeDelayIntR = juce::jlimit(1, maxBufferSize - 1, baseExactDelayIntR);  
+        releaseExciter();
 
-        // Clear only the range we'll be using
-        std::fill(exciterL.begin(), exciterL.begin() + safeDelayIntL, 0.0f);
-        std::fill(exciterR.begin(), exciterR.begin() + safeDelayIntR, 0.0f);
+        if (params.noiseSeed != noiseSeed)
+            resetNoise();
 
-        float pulseWidth = 2 * juce::jlimit(0.01f, 1.0f, (currentVelocity - minimumExciterVelocity) / (1.0f - minimumExciterVelocity));
-        float halfPeriodL = baseExactDelayFracL * 0.5f;
-        float halfPeriodR = baseExactDelayFracR * 0.5f;
+        exciterVariant = PluckExciterBank::nextVariant(exciterVariant, noise.nextBipolar());
 
-        for (int i = 0; i < safeDelayIntL; ++i)
+        if (exciterBank != nullptr)
         {
-            float squareSample = (i < halfPeriodL) ?
-                (((float)i / halfPeriodL < pulseWidth) ? plainSquareAmp : 0.0f)
-                : ((((float)(i - halfPeriodL) / halfPeriodL) < pulseWidth) ? -plainSquareAmp : 0.0f);
-
-            float randomL = juce::Random::getSystemRandom().nextFloat();
-            float noiseSampleL = ((float)i / safeDelayIntL < pulseWidth) ? (randomL * 2.0f - 1.0f) : 0.0f;
-
-            // Apply slew limiting to noiseSampleL:
-            // note: even with slew rate set to 1.0f, there was some artifacts from that so set up a conditional
-            float slewedNoiseL;
-            if (currentExciterSlewRate >= 1.0f)
-            {
-                // No slew limiting, use noise directly
-                slewedNoiseL = noiseSampleL;
-            }
-            else
+            PluckExciterBank::Request request;
+            request.note = currentMidiNote;
+            request.delayL = baseExactDelayFracL;
+            request.delayR = baseExactDelayFracR;
+            request.velocity = velocity;
+            request.color = currentColor;
+            request.exciterSlewRate = currentExciterSlewRate;
+            request.stereo = stereoEnabled;
+            request.noiseSeed = noiseSeed;
+            request.variant = exciterVariant;
+
+            if (exciterBank->acquire(request, exciterLease))
             {
-                // Apply slew limiting filter
-                float alpha = juce::jlimit(0.0f, 1.0f, currentExciterSlewRate);
-                slewedNoiseL = alpha * noiseSampleL + (1.0f - alpha) * prevNoiseL;
-                prevNoiseL = slewedNoiseL;
+                hot.exciterReadL = exciterLease.left;
+                hot.exciterReadR = exciterLease.right;
+                hot.currentExciterSizeL = exciterLease.lengthL - 1; // used in renderNextBlock
+                hot.currentExciterSizeR = exciterLease.lengthR - 1;
+
+                updateNoteTimer(currentMidiNote, hot.currentVelocity);
+                return;
             }
+        }
 
-            float excitationL = juce::jmap(currentColor, squareSample, slewedNoiseL);
-            exciterL[i] = excitationL;
+        if (exciterLeft != nullptr)
+            generateExciter(velocity, exciterLeft, exciterRight);
+    }
+
+    void releaseExciter()
+    {
+        if (exciterBank != nullptr && exciterLease.slot >= 0)
+            exciterBank->release(exciterLease);
+
+        hot.exciterReadL = exciterLeft;
+        hot.exciterReadR = exciterRight;
+    }
+
+    // FIXED EXCITER GENERATOR - NO MORE DYNAMIC RESIZING
+    // Renders exactly what the bank's table for this note, bucket and take holds
+    void generateExciter(float velocity, float* exciterL, float* exciterR)
+    {
+        // the arena sizes these for the lowest note, two spare samples for the zero tail
+        int safeDelayIntL = juce::jlimit(1, exciterCapacity - 2, baseExactDelayIntL);
+        int safeDelayIntR = juce::jlimit(1, exciterCapacity - 2, baseExactDelayIntR);
+
+        const int bucket = PluckExciterBank::getVelocityBucket(velocity);
+
+        PluckExciterBank::renderExciter(exciterL, safeDelayIntL, baseExactDelayFracL, currentMidiNote, bucket, exciterVariant, 0,
+                                        noiseSeed, currentColor, currentExciterSlewRate);
+
+        if (stereoEnabled)
+        {
+            PluckExciterBank::renderExciter(exciterR, safeDelayIntR, baseExactDelayFracR, currentMidiNote, bucket, exciterVariant, 1,
+                                            noiseSeed, currentColor, currentExciterSlewRate);
         }
 
+        // the bank's two zeros after the exciter: injection runs to ceil(delay), which a bend
+        // down or a fine tune glide at note start can push past the rounded length
+        std::fill(exciterL + safeDelayIntL, exciterL + safeDelayIntL + 2, 0.0f);
         if (stereoEnabled)
+            std::fill(exciterR + safeDelayIntR, exciterR + safeDelayIntR + 2, 0.0f);
 
-        {
-            for (int i = 0; i < safeDelayIntR; ++i)
-            {
-                float squareSample = (i < halfPeriodR) ?
-                    (((float)i / halfPeriodR < pulseWidth) ? plainSquareAmp : 0.0f)
-                    : ((((float)(i - halfPeriodR) / halfPeriodR) < pulseWidth) ? -plainSquareAmp : 0.0f);
+        // mono reads the left exciter on both sides, no copy
+        hot.exciterReadL = exciterL;
+        hot.exciterReadR = stereoEnabled ? exciterR : exciterL;
 
-                float randomR = juce::Random::getSystemRandom().nextFloat();
-                float noiseSampleR = ((float)i / safeDelayIntR < pulseWidth) ? (randomR * 2.0f - 1.0f) : 0.0f;
+        // the same length as the bank's table, nothing past it was written for this note
+        hot.currentExciterSizeL = safeDelayIntL + 1; // used in renderNextBlock
+        hot.currentExciterSizeR = (stereoEnabled ? safeDelayIntR : safeDelayIntL) + 1;
 
-                // Apply slew limiting to noiseSampleL:
-                // note: even with slew rate set to 1.0f, there was some artifacts from that so set up a conditional
-                float slewedNoiseR;
-                if (currentExciterSlewRate >= 1.0f)
-                {
-                    // No slew limiting, use noise directly
-                    slewedNoiseR = noiseSampleR;
-                }
-                else
-                {
-                    // Apply slew limiting filter
-                    float alpha = juce::jlimit(0.0f, 1.0f, currentExciterSlewRate);
-                    slewedNoiseR = alpha * noiseSampleR + (1.0f - alpha) * prevNoiseR;
-                    prevNoiseR = slewedNoiseR;
-                }
+        updateNoteTimer(currentMidiNote, velocity);
+    }
 
-                float excitationR = juce::jmap(currentColor, squareSample, slewedNoiseR);
-                exciterR[i] = excitationR;
-            }
-        }
-        else
+    // Sums the output energy over at least one period (a shorter window can land on a quiet
+    // stretch of a low note's wave) and fades the voice out once that drops below the floor.
+    // With the note timer on it still measures the level, only the floor check is off.
+    void trackEnergy(float blockEnergy, int numSamples)
+    {
+        energySum += blockEnergy;
+        energySamples += numSamples;
+
+        if (energySamples < juce::jmax(baseExactDelayIntL, baseExactDelayIntR))
+            return;
+
+        // mean square per channel against the floor
+        const float floorPower = juce::square(juce::Decibels::decibelsToGain(params.silenceFloorDb, -200.0f));
+        const bool belowFloor = ! params.noteTimer && energySum < floorPower * 2.0f * (float) energySamples;
+        level = energySum / (2.0f * (float) energySamples);
+        resetEnergy();
+
+        if (belowFloor && ! hot.fadeOut && hot.reExciteRemaining <= 0 && hot.pendingReExciteSample < 0)
         {
-            exciterR = exciterL;
+            hot.fadeOut = true;
+            hot.fadeCounter = 0;
+            hot.silenceFade = true;
         }
-        
-        currentExciterSizeL = exciterL.size(); // used in renderNextBlock
-        currentExciterSizeR = exciterR.size(); // used in renderNextBlock
+    }
 
-        updateNoteTimer(currentMidiNote, currentVelocity);
+    void resetEnergy()
+    {
+        energySum = 0.0f;
+        energySamples = 0;
     }
 
+    // The old pitch based timer, only with PluckParameters::noteTimer. Otherwise
+    // voices end when trackEnergy() finds them below the silence floor.
     void updateNoteTimer(int midiNoteNumber, float velocity)
     {
-        float minNote = 24.0f;
-        float maxNote = 108.0f;
-        float ratio = 60.0f;
-        float clampedNote = juce::jlimit(minNote, maxNote, static_cast<float>(currentMidiNote));
+        if (! params.noteTimer)
+            hot.maxSamplesAllowed = std::numeric_limits<int>::max();
+        else if (hasCoefficientTable())
+            hot.maxSamplesAllowed = coefficientTable->getNoteTimerSamples(currentMidiNote);
+        else
+            hot.maxSamplesAllowed = PluckCoefficientTable::computeNoteTimerSamples(PluckCoefficientTable::getNoteTimerFactor(currentMidiNote),
+                                                                                   currentDecay, currentDamp, currentSampleRate);
+        hot.activeSampleCounter = 0;
+    }
+
+    // Everything the per-sample loop reads or writes, in one cache line. The
+    // settings below only change per block or per note.
+    struct alignas(64) HotState
+    {
+        const float* exciterReadL = nullptr;    // where the loops read the exciter from: a bank table or exciterLeft/Right
+        const float* exciterReadR = nullptr;
+        float previousSampleL = 0.0f;
+        float previousSampleR = 0.0f;
+        float currentVelocity = 1.0f;
+        int activeSampleCounter = 0;
+        int maxSamplesAllowed = 0;
+        int currentExciterSizeL = 0;
+        int currentExciterSizeR = 0;
+        int reExciteRemaining = 0;              // timer cutoff is held off while > 0
+        int pendingReExciteSample = -1;
+        int fadeCounter = 0;
+        bool fadeOut = false;
+        bool silenceFade = false;               // fading because trackEnergy() found it silent
+        bool timerFade = false;                 // fading because the note timer ran out
+        bool shedFade = false;                  // fading because the adaptive voice cap dropped it
+    };
+
+    static_assert(sizeof(HotState) == 64, "the voice's hot state should fit one cache line");
+
+
+    HotState hot;
+
+    struct LoopRamps
+    {
+        PluckRamp feedback, damping, curve;
+    };
 
-        float decayMultiplier = std::pow(
-            ratio,
-            (maxNote - clampedNote) / (maxNote - minNote)
-        );
+    LoopRamps loopRamps;
 
-        float baseDecayTime = juce::jlimit(0.05f, 60.0f, currentDecay);
-        float normalizedDamp = juce::jmap(currentDamp, 0.0f, 0.65f, 0.0f, 1.0f);
-        float dampMultiplier = juce::jmap(normalizedDamp, 0.0f, 1.0f, 1.0f, 0.5f);
-        float totalDecayTime = baseDecayTime * dampMultiplier * decayMultiplier * 0.25f;
+    // What renderNextBlock() carries from one span to the next
+    struct Span
+    {
+        float* outL = nullptr;
+        float* outR = nullptr;
+        PluckStringDelay::Block delayL {}, delayR {};
+        LoopRamps ramps;
+        PluckRamp bend;
+        float delayValueL = 0.0f;               // unbent delays, the bend reads relative to them
+        float delayValueR = 0.0f;
+        const float* exciterL = nullptr;        // at this span's first sample, steps 0 on a side that's done
+        const float* exciterR = nullptr;
+        int exciterStepL = 0;
+        int exciterStepR = 0;
+        float inverseFadeSamples = 0.0f;
+        float energy = 0.0f;
+    };
+
+    static constexpr float silence = 0.0f;
+
+    void endBlock(const Span& span) noexcept
+    {
+        leftDelayLine.endBlock(span.delayL);
 
-        maxSamplesAllowed = static_cast<int>(currentSampleRate * totalDecayTime);
-        activeSampleCounter = 0;
+        if (! monoString)
+            rightDelayLine.endBlock(span.delayR);
+    }
+
+    // What moves per sample besides the string itself. Steady: the loop coefficients have
+    // arrived, so the kernel doesn't step them (their clamps would hold them exactly where
+    // they are). Bending implies the coefficients may still be ramping too.
+    enum class Motion
+    {
+        steady = 0,
+        ramping,
+        bending
+    };
+
+    using Interpolation = PluckStringDelay::Interpolation;
+    using Kernel = void (PluckVoice::*)(Span&, int, int) noexcept;
+
+    // Exciting and fading change between spans, indexed [exciting * 2 + fading]. Everything
+    // else holds for the block (interpolation and mono for the note).
+    using SpanKernels = std::array<Kernel, 4>;
+
+    template <Interpolation interpolation, Motion motion, bool mono>
+    static constexpr SpanKernels makeSpanKernels() noexcept
+    {
+        return { &PluckVoice::renderSpan<interpolation, motion, mono, false, false>,
+                 &PluckVoice::renderSpan<interpolation, motion, mono, false, true>,
+                 &PluckVoice::renderSpan<interpolation, motion, mono, true, false>,
+                 &PluckVoice::renderSpan<interpolation, motion, mono, true, true> };
+    }
+
+    template <Interpolation interpolation, Motion motion>
+    static constexpr std::array<SpanKernels, 2> makeSpanKernelsForStrings() noexcept
+    {
+        return { makeSpanKernels<interpolation, motion, false>(), makeSpanKernels<interpolation, motion, true>() };
+    }
+
+    template <Interpolation interpolation>
+    static constexpr std::array<std::array<SpanKernels, 2>, 3> makeSpanKernelsForMotions() noexcept
+    {
+        return { makeSpanKernelsForStrings<interpolation, Motion::steady>(),
+                 makeSpanKernelsForStrings<interpolation, Motion::ramping>(),
+                 makeSpanKernelsForStrings<interpolation, Motion::bending>() };
+    }
+
+    // Every specialisation, built at compile time: [interpolation][motion][mono]
+    const SpanKernels& getSpanKernels(const Span& span, bool bending) const noexcept
+    {
+        static constexpr std::array<std::array<std::array<SpanKernels, 2>, 3>, 3> table
+        {
+            makeSpanKernelsForMotions<Interpolation::Linear>(),
+            makeSpanKernelsForMotions<Interpolation::Lagrange3rd>(),
+            makeSpanKernelsForMotions<Interpolation::Thiran>()
+        };
+
+        const auto& r = span.ramps;
+        const auto motion = bending ? Motion::bending
+                          : (r.feedback.isRamping() || r.damping.isRamping() || r.curve.isRamping()) ? Motion::ramping
+                          : Motion::steady;
+
+        // the ring the kernels read is the left one, a mono string has no other
+        return table[(size_t) span.delayL.interpolation][(size_t) motion][monoString ? 1 : 0];
+    }
+
+    // Samples begin..end of the block, the string loop with every per-sample test taken out:
+    // the span's flags are template arguments and the ramps are plain registers, not
+    // stepped at all once they've arrived. The one-pole and the ring keep it serial from sample to
+    // sample, it's the voice bank that runs strings side by side. A mono string runs the
+    // left side only and writes it to both outputs.
+    template <Interpolation interpolation, Motion motion, bool mono, bool exciting, bool fading>
+    void renderSpan(Span& span, int begin, int end) noexcept
+    {
+        constexpr bool bending = motion == Motion::bending;
+        constexpr bool ramping = motion != Motion::steady;
+
+        auto delayL = span.delayL;
+        auto delayR = span.delayR;
+
+        const auto& r = span.ramps;
+        float feedbackGain = r.feedback.value, dampingAmount = r.damping.value, curveAmount = r.curve.value;
+        const float feedbackStep = r.feedback.step, feedbackLow = r.feedback.low, feedbackHigh = r.feedback.high;
+        const float dampingStep = r.damping.step, dampingLow = r.damping.low, dampingHigh = r.damping.high;
+        const float curveStep = r.curve.step, curveLow = r.curve.low, curveHigh = r.curve.high;
+
+        float bend = span.bend.value;
+        const float bendStep = span.bend.step, bendLow = span.bend.low, bendHigh = span.bend.high;
+        const float delayValueL = span.delayValueL, delayValueR = span.delayValueR;
+
+        const float* const exciterL = span.exciterL;
+        const float* const exciterR = span.exciterR;
+        const int exciterStepL = span.exciterStepL, exciterStepR = span.exciterStepR;
+        const float velocity = hot.currentVelocity;
+
+        const float inverseFadeSamples = span.inverseFadeSamples;
+        int fadeCounter = hot.fadeCounter;
+
+        float previousL = hot.previousSampleL;
+        float previousR = hot.previousSampleR;
+        float energy = span.energy;
+
+        float* const outL = span.outL;
+        float* const outR = span.outR;
+
+        for (int i = begin; i < end; ++i)
+        {
+            float delayedSampleL, delayedSampleR = 0.0f;
+
+            if (bending)
+            {
+                bend = juce::jmin(bendHigh, juce::jmax(bendLow, bend + bendStep));
+                delayedSampleL = delayL.read<interpolation>(delayValueL * bend);
+
+                if (! mono)
+                    delayedSampleR = delayR.read<interpolation>(delayValueR * bend);
+            }
+            else
+            {
+                delayedSampleL = delayL.read<interpolation>();
+
+                if (! mono)
+                    delayedSampleR = delayR.read<interpolation>();
+            }
+
+            if (ramping)
+            {
+                feedbackGain = juce::jmin(feedbackHigh, juce::jmax(feedbackLow, feedbackGain + feedbackStep));
+                dampingAmount = juce::jmin(dampingHigh, juce::jmax(dampingLow, dampingAmount + dampingStep));
+                curveAmount = juce::jmin(curveHigh, juce::jmax(curveLow, curveAmount + curveStep));
+            }
+
+            // Frequency-dependent damping: curveAmount > 0 damps highs harder (brighter
+            // transient, duller sustain), < 0 lets them ring longer, see getCurveAmount()
+            const float highFreqContent = std::abs(delayedSampleL - previousL);
+            const float adaptiveDamping = juce::jlimit(0.01f, 0.99f, dampingAmount * (1.0f + curveAmount * highFreqContent));
+            float filteredSampleL = previousL + adaptiveDamping * (delayedSampleL - previousL);
+            float filteredSampleR = mono ? 0.0f : previousR + adaptiveDamping * (delayedSampleR - previousR);
+
+            if (exciting)
+            {
+                const int k = i - begin;
+                filteredSampleL += exciterL[k * exciterStepL] * velocity;
+
+                if (! mono)
+                    filteredSampleR += exciterR[k * exciterStepR] * velocity;
+            }
+
+            if (fading)
+            {
+                const float fadeMultiplier = juce::jmax(0.0f, 1.0f - (float) ++fadeCounter * inverseFadeSamples);
+                filteredSampleL *= fadeMultiplier;
+                filteredSampleR *= fadeMultiplier;
+            }
+
+            // NaN and inf to 0, as a select
+            filteredSampleL = std::abs(filteredSampleL) <= std::numeric_limits<float>::max() ? filteredSampleL : 0.0f;
+            filteredSampleR = std::abs(filteredSampleR) <= std::numeric_limits<float>::max() ? filteredSampleR : 0.0f;
+
+            const float outputL = filteredSampleL * feedbackGain;
+            const float outputR = mono ? outputL : filteredSampleR * feedbackGain;
+
+            delayL.write(outputL);
+
+            if (! mono)
+                delayR.write(outputR);
+
+            previousL = outputL;
+            previousR = outputR;
+
+            outL[i] += outputL;
+            outR[i] += outputR;
+
+            energy += outputL * outputL + outputR * outputR;
+        }
+
+        span.delayL = delayL;
+        span.delayR = mono ? delayL : delayR;
+        span.ramps.feedback.value = feedbackGain;
+        span.ramps.damping.value = dampingAmount;
+        span.ramps.curve.value = curveAmount;
+        span.bend.value = bend;
+        span.energy = energy;
+
+        hot.fadeCounter = fadeCounter;
+        hot.previousSampleL = previousL;
+        hot.previousSampleR = previousR;
     }
 
     juce::LinearSmoothedValue<float> smoothedDelayLengthL;
@@ -552,32 +1039,29 @@ private:
     // PRIVATE MEMBERS
     float currentDamp = 0.0f;
     float currentColor = 1.0f;
-    float currentVelocity = 1.0f;
     float currentDecay = 0.0f;
-    float currentFineTuneMultiplierL;
-    float currentFineTuneMultiplierR;
     float currentFineTuneCents = 0.0f;
     bool stereoEnabled = false;
     float stereoMicrotune = 0.0f;
+    bool monoString = false;            // this note runs the left string only, see startNote()
+    float delayScaleL = 1.0f;           // PluckParameters::delayScaleL / R
+    float delayScaleR = 1.0f;
 
-    float currentPitchBendSemitones = 0.0f;
-    float pitchBendRange = 2.0f; // could be user configurable (±2 semitones is default)
+    PluckRamp pitchBend;                // factor on both delays, 1 = no bend
+    float pressure = 0.0f;
+    static constexpr float pressureSustain = 0.5f;  // full pressure: half way to maxFeedbackGain
+    static constexpr float maxFeedbackGain = 0.999f;
 
     float currentDampingCurve = 0.5f;    // TESTING
 
-    float previousSampleL = 0.0f;
-    float previousSampleR = 0.0f;
-    float filteredSampleL, filteredSampleR;
-
     float noiseBias = 0.3f;
     float noiseAmp = 0.0f;
-    float plainSquareAmp = 0.43f;
-    float minimumExciterVelocity = 0.1f;
+    // exciter shape constants (plainSquareAmp, minimumExciterVelocity) live in PluckExciterBank
     
-    // PRE-ALLOCATED EXCITER BUFFERS - NO MORE DYNAMIC RESIZING
-    std::vector<float> exciterLeft, exciterRight;
-    int currentExciterSizeL;
-    int currentExciterSizeR;
+    // this voice's own exciters, in the arena
+    float* exciterLeft = nullptr;
+    float* exciterRight = nullptr;
+    int exciterCapacity = 0;
 
     float baseExactDelayFracL;
     float baseExactDelayFracR;
@@ -585,39 +1069,45 @@ private:
     int baseExactDelayIntR;
     const TuningSystem* tuningSystem = nullptr;
     
-    static constexpr int maxBufferSize = 8192;
-    static constexpr uint32_t maxBlockSize = 1024;
-    int activeSampleCounter = 0;
-    int maxSamplesAllowed = 0;
+    static constexpr int maxBufferSize = PluckStringDelay::maxSize;
     double currentSampleRate = 44100.0;
     float cyclesPerSecondL = 440.0f;
     float cyclesPerSecondR = 440.0f; 
 
-    int bufferIndex = 0;
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Lagrange3rd> leftDelayLine { maxBufferSize };
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Lagrange3rd> rightDelayLine { maxBufferSize };
+    PluckStringDelay leftDelayLine;
+    PluckStringDelay rightDelayLine;
 
     int currentMidiNote = -1;
     bool hasStartedNote = false;
-    int pendingReExciteSample = -1;
     float pendingReExciteVelocity = 0.0f;
 
     bool gateEnabled = false;
-    int gateDampingSamples = 0;
-    bool fadeOut = false;
-    int fadeCounter = 0;
+    float gateDampingSeconds = 0.0f;
+
+    // energy since the last silence check, see trackEnergy()
+    float energySum = 0.0f;
+    int energySamples = 0;
+    float level = PluckVoiceBank::unmeasuredLevel;
+    static constexpr int silenceFadeSamples = 64;
+
+    // shed voices fade over this, short enough to free the CPU soon, long enough not to click
+    static constexpr double shedFadeSeconds = 0.02;
+    int getShedFadeSamples() const { return juce::jmax(64, static_cast<int>(currentSampleRate * shedFadeSeconds)); }
     
-    int reExciterIndexL = -1;
-    int reExciterIndexR = -1;
     constexpr static float reExciteFactor = 0.5f;
-    float prevNoiseL = 0.0f;
-    float prevNoiseR = 0.0f;
     float currentExciterSlewRate = 1.0f;
 
-    std::vector<float> leftDelayBuffer;
-    std::vector<float> rightDelayBuffer;
-    std::vector<float> reExciterLeft;
-    std::vector<float> reExciterRight;
+    PluckVoiceBank* voiceBank = nullptr;
+    int bankVoiceIndex = -1;
+
+    PluckExciterBank* exciterBank = nullptr;
+    const PluckCoefficientTable* coefficientTable = nullptr;
+    PluckExciterBank::Lease exciterLease;
+
+    PluckNoise noise;
+    juce::uint32 noiseSeed = 0;
+    juce::uint32 noiseStream = 0;
+    int exciterVariant = 0;             // the exciter bank's noise take the last pluck used
 
-    juce::AudioProcessorValueTreeState& apvts;
+    const PluckParameters& params;
 };
\ No newline at end of file
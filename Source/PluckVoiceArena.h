@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    PluckVoiceArena.h
+
+    One block of memory for every voice buffer, allocated in prepareToPlay.
+    It's sized from the sample rate and the lowest note the processor lets
+    through, instead of a worst case 8192 samples per buffer.
+
+    Layout (each piece 64 byte aligned):
+
+      string rings   one power-of-two ring per string. Voice v plays
+                     strings 2v (L) and 2v + 1 (R) in the reference
+                     engine, the voice bank uses ring l for lane l. Only
+                     one engine runs at a time, so they share the rings.
+      exciters       L and R per voice, for when the exciter bank has no
+                     table for the note yet.
+
+    The block comes zeroed from the allocator and is never cleared as a
+    whole: a note clears only the part of its ring it uses, and exciters
+    are written before they're read. Large zeroed allocations are mapped
+    lazily by the OS, so a voice that never plays never commits its
+    memory, and a fresh instance costs address space, not RAM.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluckStringDelay.h"
+
+class PluckVoiceArena
+{
+public:
+    // Longest period a string can be asked for: the lowest note with fine tune all
+    // the way down (-100 cents), full stereo microtune (5) and a semitone of tuning
+    // table on top. Longer requests (a Scala mapping tuned far flat) get clamped to the
+    // ring, like the old 8192 limit.
+    static float getLongestPeriod(double sampleRate, int lowestNote)
+    {
+        constexpr float headroomCents = 100.0f + 5.0f + 100.0f;
+
+        const auto freq = juce::MidiMessage::getMidiNoteInHertz(lowestNote);
+        return static_cast<float>(sampleRate / freq) * std::pow(2.0f, headroomCents / 1200.0f);
+    }
+
+    // Allocates a fresh zeroed block, every ring starts out silent. Not realtime safe.
+    void prepare(double sampleRate, int lowestNote, int numVoicesToUse, int numStringsToUse)
+    {
+        const float longestPeriod = getLongestPeriod(sampleRate, lowestNote);
+
+        const int newRingSize = PluckStringDelay::getRingSizeFor(longestPeriod);
+        const int newExciterSize = roundUpToLine(juce::jmin(PluckStringDelay::maxSize, static_cast<int>(longestPeriod) + 2));
+        const int newNumStrings = juce::jmax(numStringsToUse, 2 * numVoicesToUse);
+
+        const size_t total = (size_t) newNumStrings * (size_t) newRingSize
+                           + (size_t) numVoicesToUse * 2 * (size_t) newExciterSize;
+
+        // even with nothing changed: handing the old block back returns the pages the
+        // last session's notes touched, where clearing it would touch all of them
+        memory.free();
+        memory.allocate(total + floatsPerLine, true);
+
+        // HeapBlock only promises malloc alignment
+        const auto address = reinterpret_cast<juce::pointer_sized_uint>(memory.get());
+        base = memory.get() + ((64 - (address & 63)) & 63) / sizeof(float);
+
+        numFloats = total;
+        ringSize = newRingSize;
+        exciterSize = newExciterSize;
+        numVoices = numVoicesToUse;
+        numStrings = newNumStrings;
+    }
+
+    bool isPrepared() const noexcept { return base != nullptr; }
+
+    float* getStringRing(int string) const noexcept
+    {
+        jassert(juce::isPositiveAndBelow(string, numStrings));
+        return base + (size_t) string * (size_t) ringSize;
+    }
+
+    float* getExciter(int voice, int channel) const noexcept
+    {
+        jassert(juce::isPositiveAndBelow(voice, numVoices) && (channel == 0 || channel == 1));
+        return base + (size_t) numStrings * (size_t) ringSize + ((size_t) voice * 2 + (size_t) channel) * (size_t) exciterSize;
+    }
+
+    int getRingSize() const noexcept { return ringSize; }
+    int getExciterSize() const noexcept { return exciterSize; }
+    size_t getNumBytes() const noexcept { return numFloats * sizeof(float); }
+
+private:
+    static constexpr int floatsPerLine = 64 / (int) sizeof(float);
+
+    static int roundUpToLine(int numSamples) noexcept
+    {
+        return (numSamples + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+    }
+
+    juce::HeapBlock<float> memory;
+    float* base = nullptr;
+    size_t numFloats = 0;
+
+    int ringSize = 0;
+    int exciterSize = 0;
+    int numVoices = 0;
+    int numStrings = 0;
+};
@@ -0,0 +1,827 @@
+/*
+  ==============================================================================
+
+    PluckVoiceBank.h
+
+    Structure-of-arrays string engine. Every PluckVoice gets a pair of string
+    lanes (L and R) in here, or a single one with STEREO off, and the bank
+    advances a whole SIMD register of lanes per instruction: 4 strings on
+    SSE/NEON, 8 on AVX2.
+
+    The loop filter, damping curve, feedback gain, exciter injection and fade
+    all run on registers. Only the delay taps and the ring writes are per lane,
+    since every string has its own period. Each lane's ring is a power of two
+    sized to its period (PluckStringDelay's layout), so high notes only touch
+    a few cache lines. The rings live in PluckVoiceArena, and what the gather
+    and scatter loops touch per lane is packed into one cache line (Lane).
+
+    PluckVoice still owns the note logic (exciters, note timer, re-excite).
+    It pushes its settings in once per block with syncVoice() and the bank
+    keeps the per-sample state, ramping the loop coefficients to new settings
+    sample by sample (PluckRamp). The old per-voice loop stays in PluckVoice as
+    the reference engine so the two can be compared.
+
+    A mono lane is added to both outputs, a stereo pair is an even / odd lane
+    pair for left and right.
+
+    A pitch bend on its way to a new value moves a lane's delay every sample.
+    Groups with such a lane take the modulated kernel, which works the read
+    weights out per lane and sample. Everyone else keeps the per-block weights.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluckStringDelay.h"
+#include "PluckRamp.h"
+#include "PluckVoiceArena.h"
+
+class PluckVoiceBank
+{
+public:
+   #if JUCE_USE_SIMD
+    using Vec = juce::dsp::SIMDRegister<float>;
+   #else
+    // no SIMD on this target, fall back to one lane per "register"
+    struct Vec
+    {
+        using vMaskType = float;
+        static constexpr size_t SIMDNumElements = 1;
+        static constexpr size_t SIMDRegisterSize = sizeof (float);
+
+        float value;
+
+        static Vec expand (float v) noexcept                  { return { v }; }
+        static Vec fromRawArray (const float* p) noexcept     { return { *p }; }
+        void copyToRawArray (float* p) const noexcept         { *p = value; }
+        static Vec min (Vec a, Vec b) noexcept                { return { std::min (a.value, b.value) }; }
+        static Vec max (Vec a, Vec b) noexcept                { return { std::max (a.value, b.value) }; }
+        static Vec abs (Vec a) noexcept                       { return { std::abs (a.value) }; }
+        static float equal (Vec a, Vec b) noexcept            { return a.value == b.value ? 1.0f : 0.0f; }
+        Vec operator+ (Vec o) const noexcept                  { return { value + o.value }; }
+        Vec operator- (Vec o) const noexcept                  { return { value - o.value }; }
+        Vec operator* (Vec o) const noexcept                  { return { value * o.value }; }
+        Vec operator& (float mask) const noexcept             { return { mask != 0.0f ? value : 0.0f }; }
+    };
+   #endif
+
+    static constexpr int laneWidth = (int) Vec::SIMDNumElements;
+    static constexpr int maxRingSize = PluckStringDelay::maxSize;
+
+    // a voice's level before its first energy window: as loud as can be, never the first to shed
+    static constexpr float unmeasuredLevel = std::numeric_limits<float>::max();
+
+    // what a voice hands over once per block
+    struct VoiceSettings
+    {
+        float delayL = 1.0f;            // fractional delay in samples
+        float delayR = 1.0f;
+        float bend = 1.0f;              // pitch bend as a factor on both delays, heading for
+        float bendTarget = 1.0f;        // bendTarget in a straight line over bendSamples
+        int bendSamples = 0;
+        float feedbackGain = 0.0f;      // loop coefficient targets, the lanes ramp there (see PluckRamp)
+        float damping = 0.5f;           // one-pole coefficient before the curve
+        float curveAmount = 0.0f;       // getCurveAmount (dampingCurve)
+        int rampSamples = 0;            // how long the ramp to a new target takes, a new note jumps
+        float velocity = 1.0f;
+        int fadeSamples = 64;           // GATEDAMPING in samples
+        int maxSamplesAllowed = 0;      // note timer
+        int exciterLengthL = maxRingSize;   // readable exciter samples, injection stops there at the latest
+        int exciterLengthR = maxRingSize;
+        PluckStringDelay::Interpolation interpolation = PluckStringDelay::Interpolation::Lagrange3rd;
+        float silenceFloor = 0.0f;      // mean square per channel that ends the voice, 0 = never
+        int energyWindow = 1;           // samples per silence check, at least one period
+    };
+
+    //==============================================================================
+    void prepare (int numVoicesToUse)
+    {
+        numVoices = numVoicesToUse;
+        numLanes = 2 * numVoices;
+        numGroups = (numLanes + laneWidth - 1) / laneWidth;
+
+        const int paddedLanes = numGroups * laneWidth;
+
+        for (auto* arr : { &prev, &tap1Gain, &tap2Gain, &tap3Gain, &tap4Gain, &allpass, &allpassState,
+                           &velocity, &fadeGain, &fadeStep, &energy })
+            arr->assign ((size_t) numGroups, Vec::expand (0.0f));
+
+        for (auto* ramp : { &feedback, &damping, &curveAmount })
+        {
+            for (auto* arr : { &ramp->value, &ramp->step, &ramp->low, &ramp->high })
+                arr->assign ((size_t) numGroups, Vec::expand (0.0f));
+
+            ramp->target.assign ((size_t) paddedLanes, 0.0f);
+        }
+
+        lanes.assign ((size_t) paddedLanes, Lane {});
+        fadeSamples.assign ((size_t) paddedLanes, 0);
+        laneNeedsSizing.assign ((size_t) paddedLanes, false);
+        laneMono.assign ((size_t) paddedLanes, 0);
+        laneShedFade.assign ((size_t) paddedLanes, 0);
+        ringCapacity = 0;
+
+        voiceLane.assign ((size_t) numVoices, -1);
+        voiceLaneCount.assign ((size_t) numVoices, 0);
+        voiceEnergy.assign ((size_t) numVoices, VoiceEnergy {});
+        laneOwner.assign ((size_t) paddedLanes, -1);
+        groupActiveCount.assign ((size_t) numGroups, 0);
+        groupMonoCount.assign ((size_t) numGroups, 0);
+    }
+
+    // Lane l plays string l of the arena. Call from prepareToPlay with every voice stopped.
+    void setRings (const PluckVoiceArena& arena)
+    {
+        jassert (arena.isPrepared());
+        ringCapacity = arena.getRingSize();
+
+        for (int l = 0; l < getNumPaddedLanes(); ++l)
+        {
+            auto& lane = lanes[(size_t) l];
+            lane.ring = arena.getStringRing (l);
+            lane.mask = 3;
+            lane.writePos = 0;
+        }
+    }
+
+    // lanes including the padding of the last group, the arena needs a ring for each
+    int getNumPaddedLanes() const noexcept            { return numGroups * laneWidth; }
+
+    void setEnabled (bool shouldBeEnabled) noexcept   { enabled = shouldBeEnabled; }
+    bool isEnabled() const noexcept                   { return enabled; }
+    bool isPrepared() const noexcept                  { return numVoices > 0; }
+    bool hasRings() const noexcept                    { return ringCapacity > 0; }
+
+    //==============================================================================
+    // Grabs the lowest free lane pair (or lane, for a mono string) so active strings stay packed together.
+    void startVoice (int voice, const float* exciterL, const float* exciterR, bool mono = false)
+    {
+        if (! juce::isPositiveAndBelow (voice, numVoices) || ! hasRings())
+            return;
+
+        releaseVoice (voice);
+
+        const int count = mono ? 1 : 2;
+        int lane = -1;
+
+        for (int l = 0; l < numLanes; l += count)
+        {
+            if (laneOwner[(size_t) l] < 0 && (mono || laneOwner[(size_t) l + 1] < 0))
+            {
+                lane = l;
+                break;
+            }
+        }
+
+        if (lane < 0)
+            return;
+
+        voiceLane[(size_t) voice] = lane;
+        voiceLaneCount[(size_t) voice] = count;
+        voiceEnergy[(size_t) voice].samples = 0;
+        voiceEnergy[(size_t) voice].level = unmeasuredLevel;
+
+        if (mono)
+        {
+            laneMono[(size_t) lane] = 1;
+            ++groupMonoCount[(size_t) (lane / laneWidth)];
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            const int l = lane + i;
+            auto& hot = lanes[(size_t) l];
+            laneOwner[(size_t) l] = voice;
+            hot.owned = true;
+            hot.exciter = (i == 0) ? exciterL : exciterR;
+            hot.writePos = 0;
+            hot.sampleCounter = 0;
+            hot.reExciteRemaining = 0;
+            hot.delayRamp = 0;
+            hot.fading = false;
+            hot.silenceFade = false;
+            hot.timerFade = false;
+            laneShedFade[(size_t) l] = 0;
+            laneNeedsSizing[(size_t) l] = true; // ring gets sized and cleared by the first syncVoice
+
+            setLaneValue (prev, l, 0.0f);
+            setLaneValue (allpassState, l, 0.0f);
+            setLaneValue (fadeGain, l, 1.0f);
+            setLaneValue (fadeStep, l, 0.0f);
+            setLaneValue (energy, l, 0.0f);
+
+            ++groupActiveCount[(size_t) (l / laneWidth)];
+        }
+    }
+
+    void releaseVoice (int voice)
+    {
+        if (! juce::isPositiveAndBelow (voice, numVoices))
+            return;
+
+        const int lane = voiceLane[(size_t) voice];
+        if (lane < 0)
+            return;
+
+        const int count = voiceLaneCount[(size_t) voice];
+
+        for (int l = lane; l < lane + count; ++l)
+        {
+            auto& hot = lanes[(size_t) l];
+            laneOwner[(size_t) l] = -1;
+            hot.owned = false;
+            hot.exciter = nullptr;
+            hot.injectLimit = 0;
+            hot.delayRamp = 0;
+            hot.fading = false;
+
+            // silent lanes still run when they share a group with live ones
+            setRampTarget (feedback, l, 0.0f, 0);
+            setLaneValue (velocity, l, 0.0f);
+            setLaneValue (prev, l, 0.0f);
+            setLaneValue (fadeStep, l, 0.0f);
+
+            --groupActiveCount[(size_t) (l / laneWidth)];
+        }
+
+        if (count == 1)
+        {
+            laneMono[(size_t) lane] = 0;
+            --groupMonoCount[(size_t) (lane / laneWidth)];
+        }
+
+        voiceLane[(size_t) voice] = -1;
+        voiceLaneCount[(size_t) voice] = 0;
+    }
+
+    // Re-excites and shared exciter tables hand the voice a different exciter mid-note.
+    void setVoiceExciter (int voice, const float* exciterL, const float* exciterR)
+    {
+        const int lane = getLane (voice);
+        if (lane < 0)
+            return;
+
+        lanes[(size_t) lane].exciter = exciterL;
+
+        if (getLaneCount (voice) > 1)
+            lanes[(size_t) lane + 1].exciter = exciterR;
+    }
+
+    // Restart exciter injection and the note timer, keep whatever is ringing.
+    void reExciteVoice (int voice, int guardSamples)
+    {
+        const int lane = getLane (voice);
+        if (lane < 0)
+            return;
+
+        for (int l = lane; l < lane + getLaneCount (voice); ++l)
+        {
+            auto& hot = lanes[(size_t) l];
+            hot.sampleCounter = 0;
+            hot.reExciteRemaining = guardSamples;
+            hot.fading = false;
+            hot.silenceFade = false;
+            hot.timerFade = false;
+            laneShedFade[(size_t) l] = 0;
+            setLaneValue (fadeGain, l, 1.0f);
+            setLaneValue (fadeStep, l, 0.0f);
+            setLaneValue (energy, l, 0.0f);
+        }
+
+        voiceEnergy[(size_t) voice].samples = 0;
+        voiceEnergy[(size_t) voice].level = unmeasuredLevel;
+    }
+
+    void beginFade (int voice)
+    {
+        const int lane = getLane (voice);
+        if (lane < 0)
+            return;
+
+        for (int l = lane; l < lane + getLaneCount (voice); ++l)
+        {
+            lanes[(size_t) l].silenceFade = false;
+            lanes[(size_t) l].timerFade = false;
+            laneShedFade[(size_t) l] = 0;
+            startLaneFade (l, fadeSamples[(size_t) l]);
+        }
+    }
+
+    // The adaptive voice cap's fade: its own length, whatever GATEDAMPING says
+    void shedVoice (int voice, int samples)
+    {
+        const int lane = getLane (voice);
+        if (lane < 0)
+            return;
+
+        for (int l = lane; l < lane + getLaneCount (voice); ++l)
+        {
+            lanes[(size_t) l].silenceFade = false;
+            lanes[(size_t) l].timerFade = false;
+            laneShedFade[(size_t) l] = 1;
+            startLaneFade (l, samples);
+        }
+    }
+
+    void syncVoice (int voice, const VoiceSettings& s)
+    {
+        const int lane = getLane (voice);
+        if (lane < 0)
+            return;
+
+        for (int i = 0; i < getLaneCount (voice); ++i)
+        {
+            const int l = lane + i;
+            const float delay = (i == 0) ? s.delayL : s.delayR;
+            const int exciterLength = (i == 0) ? s.exciterLengthL : s.exciterLengthR;
+
+            auto& hot = lanes[(size_t) l];
+
+            // a new note starts on its coefficients, a playing one ramps over
+            const int rampSamples = laneNeedsSizing[(size_t) l] ? 0 : s.rampSamples;
+            setRampTarget (feedback, l, s.feedbackGain, rampSamples);
+            setRampTarget (damping, l, s.damping, rampSamples);
+            setRampTarget (curveAmount, l, s.curveAmount, rampSamples);
+
+            // bending: start at the bent delay and walk to the target one sample at a time
+            const float bentDelay = delay * s.bend;
+            const float targetDelay = delay * s.bendTarget;
+
+            hot.interpolation = s.interpolation;
+            hot.delay = bentDelay;
+            hot.delayRamp = s.bendSamples;
+            hot.delayStep = s.bendSamples > 0 ? (targetDelay - bentDelay) / (float) s.bendSamples : 0.0f;
+
+            setDelay (l, bentDelay, juce::jmax (bentDelay, targetDelay), s.interpolation);
+            hot.injectLimit = hot.exciter != nullptr
+                                ? juce::jlimit (0, juce::jmin (ringCapacity, exciterLength), (int) std::ceil (delay))
+                                : 0;
+            hot.maxSamples = s.maxSamplesAllowed;
+            fadeSamples[(size_t) l] = s.fadeSamples > 0 ? s.fadeSamples : 64;
+
+            setLaneValue (velocity, l, s.velocity);
+
+            if (hot.fading && ! hot.silenceFade && laneShedFade[(size_t) l] == 0)
+                setLaneValue (fadeStep, l, 1.0f / (float) fadeSamples[(size_t) l]);
+        }
+
+        voiceEnergy[(size_t) voice].floor = s.silenceFloor;
+        voiceEnergy[(size_t) voice].window = juce::jmax (1, s.energyWindow);
+    }
+
+    // Same mapping as the reference loop: >0.5 damps highs harder, <0.5 lets them ring.
+    static float getCurveAmount (float dampingCurve) noexcept
+    {
+        return dampingCurve > 0.5f ? (dampingCurve - 0.5f) * 2.0f * 0.5f
+                                   : -(0.5f - dampingCurve) * 2.0f * 0.3f;
+    }
+
+    // true once the fade of this voice has run all the way down
+    bool hasVoiceFinished (int voice) const
+    {
+        const int lane = getLane (voice);
+        return lane >= 0 && lanes[(size_t) lane].fading && laneValue (fadeGain, lane) <= 0.0f;
+    }
+
+    // fading out for whatever reason, it's on its way out
+    bool isFading (int voice) const
+    {
+        const int lane = getLane (voice);
+        return lane >= 0 && lanes[(size_t) lane].fading;
+    }
+
+    // Mean square per output over the last energy window, unmeasuredLevel until one has passed
+    float getLevel (int voice) const
+    {
+        return juce::isPositiveAndBelow (voice, numVoices) ? voiceEnergy[(size_t) voice].level : unmeasuredLevel;
+    }
+
+    // why a finished voice faded, for PluckTelemetry (neither: note-off / gate)
+    bool endedOnTimer (int voice) const
+    {
+        const int lane = getLane (voice);
+        return lane >= 0 && (lanes[(size_t) lane].timerFade
+                              || (getLaneCount (voice) > 1 && lanes[(size_t) lane + 1].timerFade));
+    }
+
+    bool endedOnSilence (int voice) const
+    {
+        const int lane = getLane (voice);
+        return lane >= 0 && lanes[(size_t) lane].silenceFade;
+    }
+
+    int getLane (int voice) const
+    {
+        return juce::isPositiveAndBelow (voice, numVoices) ? voiceLane[(size_t) voice] : -1;
+    }
+
+    // 2 for a stereo pair, 1 for a mono string, 0 when the voice has no lanes
+    int getLaneCount (int voice) const
+    {
+        return juce::isPositiveAndBelow (voice, numVoices) ? voiceLaneCount[(size_t) voice] : 0;
+    }
+
+    //==============================================================================
+    // Adds every active string into outL/outR (outR may alias outL for mono).
+    void render (float* outL, float* outR, int numSamples)
+    {
+        for (int g = 0; g < numGroups; ++g)
+            if (isGroupActive (g))
+                renderGroup (g, outL, outR, numSamples);
+
+        endRender (numSamples);
+    }
+
+    // The same in pieces, for PluckRenderPool: renderGroup() for every active group, from
+    // any thread as long as no two threads share a group, then endRender() once on the
+    // audio thread.
+    int getNumGroups() const noexcept                 { return numGroups; }
+    bool isGroupActive (int group) const noexcept     { return groupActiveCount[(size_t) group] > 0; }
+
+    // Runs the group through the kernel compiled for its case: [modulated][ramping]
+    void renderGroup (int group, float* outL, float* outR, int numSamples)
+    {
+        using GroupKernel = void (PluckVoiceBank::*) (int, float*, float*, int);
+
+        static constexpr GroupKernel kernels[2][2] =
+        {
+            { &PluckVoiceBank::renderGroupLanes<false, false>, &PluckVoiceBank::renderGroupLanes<false, true> },
+            { &PluckVoiceBank::renderGroupLanes<true, false>,  &PluckVoiceBank::renderGroupLanes<true, true> }
+        };
+
+        (this->*kernels[isGroupModulated (group) ? 1 : 0][isGroupRamping (group) ? 1 : 0]) (group, outL, outR, numSamples);
+    }
+
+    void endRender (int numSamples) { checkSilence (numSamples); }
+
+private:
+    //==============================================================================
+    bool isGroupModulated (int group) const noexcept
+    {
+        for (int l = group * laneWidth; l < (group + 1) * laneWidth; ++l)
+            if (lanes[(size_t) l].delayRamp > 0)
+                return true;
+
+        return false;
+    }
+
+    // any lane's loop coefficients still on their way to a new target
+    bool isGroupRamping (int group) const noexcept
+    {
+        for (int l = group * laneWidth; l < (group + 1) * laneWidth; ++l)
+            for (const auto* r : { &feedback, &damping, &curveAmount })
+                if (laneValue (r->value, l) != r->target[(size_t) l])
+                    return true;
+
+        return false;
+    }
+
+    // modulated: some lane's delay moves per sample, so the read weights do too.
+    // ramping: some lane's coefficients are still stepping, otherwise the clamps would
+    // only hold every lane where it is and are left out.
+    template <bool modulated, bool ramping>
+    void renderGroupLanes (int group, float* outL, float* outR, int numSamples)
+    {
+        const int base = group * laneWidth;
+        float* const out[2] = { outL, outR };
+        const bool anyMono = groupMonoCount[(size_t) group] > 0;
+
+        alignas (Vec::SIMDRegisterSize) float tap1[laneWidth];
+        alignas (Vec::SIMDRegisterSize) float tap2[laneWidth];
+        alignas (Vec::SIMDRegisterSize) float tap3[laneWidth];
+        alignas (Vec::SIMDRegisterSize) float tap4[laneWidth];
+        alignas (Vec::SIMDRegisterSize) float inject[laneWidth];
+        alignas (Vec::SIMDRegisterSize) float result[laneWidth];
+        alignas (Vec::SIMDRegisterSize) float weights[5][laneWidth];
+
+        const auto g = (size_t) group;
+        Vec k1 = tap1Gain[g], k2 = tap2Gain[g], k3 = tap3Gain[g], k4 = tap4Gain[g], ap = allpass[g];
+        const Vec vel = velocity[g];
+        const Vec one = Vec::expand (1.0f), zero = Vec::expand (0.0f);
+        const Vec minDamp = Vec::expand (0.01f), maxDamp = Vec::expand (0.99f);
+
+        // loop coefficients, one PluckRamp step per sample
+        Vec fb = feedback.value[g], damp = damping.value[g], curve = curveAmount.value[g];
+        const Vec fbStep = feedback.step[g], fbLow = feedback.low[g], fbHigh = feedback.high[g];
+        const Vec dampStep = damping.step[g], dampLow = damping.low[g], dampHigh = damping.high[g];
+        const Vec curveStep = curveAmount.step[g], curveLow = curveAmount.low[g], curveHigh = curveAmount.high[g];
+
+        Vec last = prev[g];
+        Vec apLast = allpassState[g];
+        Vec gain = fadeGain[g];
+        Vec step = fadeStep[g];
+        Vec sumOfSquares = energy[g];
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            // gather: the only per-lane part, every string has its own period
+            for (int i = 0; i < laneWidth; ++i)
+            {
+                auto& lane = lanes[(size_t) (base + i)];
+                const float* ring = lane.ring;
+                const int mask = lane.mask;
+                int tapOffset = lane.tapOffset;
+
+                if (modulated)
+                {
+                    if (lane.delayRamp > 0)
+                    {
+                        lane.delay += lane.delayStep;
+                        --lane.delayRamp;
+                    }
+
+                    const auto w = PluckStringDelay::getReadWeights (lane.delay, lane.interpolation, mask + 1);
+                    tapOffset = w.offset;
+                    weights[0][i] = w.k1;
+                    weights[1][i] = w.k2;
+                    weights[2][i] = w.k3;
+                    weights[3][i] = w.k4;
+                    weights[4][i] = w.allpass;
+                }
+
+                const int p = lane.writePos - tapOffset;
+
+                tap1[i] = ring[p & mask];
+                tap2[i] = ring[(p - 1) & mask];
+                tap3[i] = ring[(p - 2) & mask];
+                tap4[i] = ring[(p - 3) & mask];
+
+                const int c = lane.sampleCounter;
+                inject[i] = c < lane.injectLimit ? lane.exciter[c] : 0.0f;
+            }
+
+            if (modulated)
+            {
+                k1 = Vec::fromRawArray (weights[0]);
+                k2 = Vec::fromRawArray (weights[1]);
+                k3 = Vec::fromRawArray (weights[2]);
+                k4 = Vec::fromRawArray (weights[3]);
+                ap = Vec::fromRawArray (weights[4]);
+            }
+
+            // fractional read, weights folded per block: Lagrange / linear use the taps,
+            // Thiran lanes take tap2 plus the allpass term (ap is 0 everywhere else)
+            const Vec t1 = Vec::fromRawArray (tap1);
+            const Vec delayed = t1 * k1 + Vec::fromRawArray (tap2) * k2
+                              + Vec::fromRawArray (tap3) * k3 + Vec::fromRawArray (tap4) * k4
+                              + ap * (t1 - apLast);
+            apLast = delayed;
+
+            if (ramping)
+            {
+                fb = Vec::min (fbHigh, Vec::max (fbLow, fb + fbStep));
+                damp = Vec::min (dampHigh, Vec::max (dampLow, damp + dampStep));
+                curve = Vec::min (curveHigh, Vec::max (curveLow, curve + curveStep));
+            }
+
+            // one-pole with the frequency dependent damping curve
+            const Vec diff = delayed - last;
+            const Vec adaptive = Vec::min (maxDamp, Vec::max (minDamp, damp * (one + curve * Vec::abs (diff))));
+            Vec filtered = last + adaptive * diff + Vec::fromRawArray (inject) * vel;
+
+            gain = Vec::max (zero, gain - step);
+            filtered = filtered * gain;
+
+            Vec y = filtered * fb;
+            y = y & Vec::equal (y, y); // NaN -> 0
+            last = y;
+            sumOfSquares = sumOfSquares + y * y;
+
+            y.copyToRawArray (result);
+
+            // scatter back into the rings and the output, tick the note timers
+            bool stepChanged = false;
+
+            for (int i = 0; i < laneWidth; ++i)
+            {
+                auto& lane = lanes[(size_t) (base + i)];
+
+                lane.ring[lane.writePos & lane.mask] = result[i];
+                ++lane.writePos;
+
+                if (anyMono && laneMono[(size_t) (base + i)] != 0)
+                {
+                    outL[n] += result[i];
+                    outR[n] += result[i];
+                }
+                else
+                {
+                    out[(base + i) & 1][n] += result[i];
+                }
+
+                // saturates instead of wrapping: a note without a timer can ring for hours,
+                // padding and free lanes tick forever
+                if (lane.sampleCounter < std::numeric_limits<int>::max())
+                    ++lane.sampleCounter;
+
+                const int c = lane.sampleCounter;
+                if (lane.reExciteRemaining > 0)
+                    --lane.reExciteRemaining;
+
+                if (! lane.fading && lane.owned && c >= lane.maxSamples && lane.reExciteRemaining <= 0)
+                {
+                    lane.timerFade = true;
+                    startLaneFade (base + i, fadeSamples[(size_t) (base + i)]);
+                    stepChanged = true;
+                }
+            }
+
+            // lanes that just started fading still sit at gain 1, only the step moves
+            if (stepChanged)
+                step = fadeStep[g];
+        }
+
+        prev[g] = last;
+        allpassState[g] = apLast;
+        fadeGain[g] = gain;
+        energy[g] = sumOfSquares;
+        feedback.value[g] = fb;
+        damping.value[g] = damp;
+        curveAmount.value[g] = curve;
+
+        // wrap the write positions back into the rings, as PluckStringDelay::endBlock() does
+        for (int l = base; l < base + laneWidth; ++l)
+            lanes[(size_t) l].writePos &= lanes[(size_t) l].mask;
+
+        // leave the per-block weights where the sweep got to
+        if (modulated)
+            for (int l = base; l < base + laneWidth; ++l)
+                setReadWeights (l, lanes[(size_t) l].delay, lanes[(size_t) l].interpolation);
+    }
+
+    void startLaneFade (int lane, int samples)
+    {
+        lanes[(size_t) lane].fading = true;
+        setLaneValue (fadeGain, lane, 1.0f);
+        setLaneValue (fadeStep, lane, 1.0f / (float) juce::jmax (1, samples));
+    }
+
+    // Block granularity: once a voice has run for a full energy window, compare the mean
+    // square of its two lanes with its floor and fade it out if it's gone quiet.
+    void checkSilence (int numSamples)
+    {
+        for (int v = 0; v < numVoices; ++v)
+        {
+            const int lane = voiceLane[(size_t) v];
+            if (lane < 0)
+                continue;
+
+            auto& e = voiceEnergy[(size_t) v];
+            e.samples += numSamples;
+
+            if (e.samples < e.window)
+                continue;
+
+            // a mono string counts once per output, like its stereo pair would
+            const int count = voiceLaneCount[(size_t) v];
+            const float sum = count > 1 ? laneValue (energy, lane) + laneValue (energy, lane + 1)
+                                        : 2.0f * laneValue (energy, lane);
+            const bool belowFloor = sum < e.floor * 2.0f * (float) e.samples;
+
+            e.level = sum / (2.0f * (float) e.samples);
+            e.samples = 0;
+
+            for (int l = lane; l < lane + count; ++l)
+                setLaneValue (energy, l, 0.0f);
+
+            auto& left = lanes[(size_t) lane];
+
+            if (belowFloor && ! left.fading && left.reExciteRemaining <= 0)
+            {
+                for (int l = lane; l < lane + count; ++l)
+                {
+                    lanes[(size_t) l].silenceFade = true;
+                    startLaneFade (l, silenceFadeSamples);
+                }
+            }
+        }
+    }
+
+    // maxDelay: how far a bend takes the delay before the next sync, the ring is sized for it
+    void setDelay (int lane, float delay, float maxDelay, PluckStringDelay::Interpolation interpolation)
+    {
+        const auto l = (size_t) lane;
+        auto& hot = lanes[l];
+        const int needed = PluckStringDelay::getRingSizeFor (maxDelay, ringCapacity);
+        const int size = hot.mask + 1;
+
+        if (laneNeedsSizing[l])
+        {
+            // new note: only clear what this period uses
+            laneNeedsSizing[l] = false;
+            hot.mask = needed - 1;
+            hot.writePos = 0;
+            std::fill (hot.ring, hot.ring + needed, 0.0f);
+        }
+        else if (needed > size)
+        {
+            PluckStringDelay::growRing (hot.ring, size, needed, hot.writePos);
+            hot.mask = needed - 1;
+        }
+
+        setReadWeights (lane, delay, interpolation);
+    }
+
+    void setReadWeights (int lane, float delay, PluckStringDelay::Interpolation interpolation)
+    {
+        // same weights (and juce::dsp::DelayLine indexing) as the reference engine
+        const auto w = PluckStringDelay::getReadWeights (delay, interpolation, ringCapacity);
+
+        lanes[(size_t) lane].tapOffset = w.offset;
+        setLaneValue (tap1Gain, lane, w.k1);
+        setLaneValue (tap2Gain, lane, w.k2);
+        setLaneValue (tap3Gain, lane, w.k3);
+        setLaneValue (tap4Gain, lane, w.k4);
+        setLaneValue (allpass, lane, w.allpass);
+    }
+
+    static float* lanesOf (std::vector<Vec>& v) noexcept               { return reinterpret_cast<float*> (v.data()); }
+    static const float* lanesOf (const std::vector<Vec>& v) noexcept   { return reinterpret_cast<const float*> (v.data()); }
+    static void setLaneValue (std::vector<Vec>& v, int lane, float value) noexcept { lanesOf (v)[lane] = value; }
+    static float laneValue (const std::vector<Vec>& v, int lane) noexcept      { return lanesOf (v)[lane]; }
+
+    // a PluckRamp per lane: value, step and range in registers, the target cold
+    struct LaneRamps
+    {
+        std::vector<Vec> value, step, low, high;
+        std::vector<float> target;
+    };
+
+    static void setRampTarget (LaneRamps& r, int lane, float newTarget, int rampSamples) noexcept
+    {
+        PluckRamp ramp;
+        ramp.value = laneValue (r.value, lane);
+        ramp.target = r.target[(size_t) lane];
+        ramp.step = laneValue (r.step, lane);
+        ramp.low = laneValue (r.low, lane);
+        ramp.high = laneValue (r.high, lane);
+
+        ramp.setTarget (newTarget, rampSamples);
+
+        setLaneValue (r.value, lane, ramp.value);
+        setLaneValue (r.step, lane, ramp.step);
+        setLaneValue (r.low, lane, ramp.low);
+        setLaneValue (r.high, lane, ramp.high);
+        r.target[(size_t) lane] = ramp.target;
+    }
+
+    //==============================================================================
+    int numVoices = 0;
+    int numLanes = 0;
+    int numGroups = 0;
+    bool enabled = false;
+
+    // hot per-lane state, one register per group of laneWidth strings
+    std::vector<Vec> prev, tap1Gain, tap2Gain, tap3Gain, tap4Gain, allpass, allpassState;
+    std::vector<Vec> velocity, fadeGain, fadeStep;
+    LaneRamps feedback, damping, curveAmount;
+    std::vector<Vec> energy;                    // sum of squares since the voice's last silence check
+
+    // hot per-lane scalars, everything the gather / scatter loops touch for one string
+    struct alignas (64) Lane
+    {
+        float* ring = nullptr;                  // ringCapacity floats in the arena, the first mask + 1 in use
+        const float* exciter = nullptr;
+        int mask = 3;
+        int writePos = 0;
+        int tapOffset = 1;
+        int sampleCounter = 0;
+        int injectLimit = 0;
+        int maxSamples = 0;                     // note timer
+        int reExciteRemaining = 0;
+        float delay = 1.0f;                     // the bent delay, moved by delayStep for delayRamp more samples
+        float delayStep = 0.0f;
+        int delayRamp = 0;
+        PluckStringDelay::Interpolation interpolation = PluckStringDelay::Interpolation::Lagrange3rd;
+        bool owned = false;
+        bool fading = false;
+        bool silenceFade = false;
+        bool timerFade = false;
+    };
+
+    static_assert (sizeof (Lane) == 64, "one cache line per lane");
+
+    std::vector<Lane> lanes;
+    int ringCapacity = 0;
+
+    // cold per-lane settings
+    std::vector<int> fadeSamples;
+    std::vector<bool> laneNeedsSizing;
+    std::vector<char> laneMono;                 // one string feeding both outputs
+    std::vector<char> laneShedFade;             // shedVoice(): keeps its own fade length through syncVoice()
+
+    struct VoiceEnergy
+    {
+        float floor = 0.0f;
+        int window = 1;
+        int samples = 0;
+        float level = unmeasuredLevel;
+    };
+
+    static constexpr int silenceFadeSamples = 64;   // same as the reference loop
+
+    std::vector<VoiceEnergy> voiceEnergy;
+    std::vector<int> voiceLane, voiceLaneCount, laneOwner, groupActiveCount, groupMonoCount;
+};
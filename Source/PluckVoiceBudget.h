@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    PluckVoiceBudget.h
+
+    The adaptive voice cap (ADAPTIVEVOICES). MAXVOICES is how many voices
+    the user allows; this is how many the machine can afford right now.
+    The processor hands it each block's load (processBlock time over the
+    block's deadline, as PluckTelemetry measures it) and the number of
+    playing voices, and reads a cap back for the next block.
+
+    When the smoothed load climbs past targetLoad the cap drops straight
+    to the voice count that would have fit the target at the measured
+    cost per voice. The voice count is smoothed with the same pole as the
+    load, so the cost per voice stays right while both come down after a
+    cut (the shed voices are gone long before the load has caught up).
+    Once it stays under recoverLoad, one voice comes back every
+    recoverSeconds, up to MAXVOICES. PluckSynth fades out whatever is
+    over the cap, quietest first, instead of cutting it.
+
+    Audio thread only. Offline renders leave it off so they stay
+    repeatable.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PluckVoiceBudget
+{
+public:
+    static constexpr float targetLoad = 0.7f;       // where the cap comes down to
+    static constexpr float recoverLoad = 0.5f;      // below this voices are given back
+    static constexpr double smoothingSeconds = 0.05;
+    static constexpr double recoverSeconds = 0.1;   // per voice given back
+    static constexpr int minimumVoices = 4;         // the MAXVOICES minimum, re-excitement needs a few
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    // Back to no limit of its own, e.g. when the mode is switched off
+    void reset() noexcept
+    {
+        cap = std::numeric_limits<int>::max();
+        smoothedLoad = 0.0f;
+        smoothedVoices = 0.0f;
+        headroomSamples = 0;
+    }
+
+    // The cap for the next block, never above what the user allows
+    int getCap(int maxVoices) const noexcept { return juce::jlimit(juce::jmin(minimumVoices, maxVoices), maxVoices, cap); }
+
+    // After each block
+    void endBlock(float load, int activeVoices, int numSamples, int maxVoices) noexcept
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return;
+
+        // a one pole over smoothingSeconds, but an overload counts at once
+        const float coefficient = (float) (1.0 - std::exp(-(double) numSamples / (smoothingSeconds * sampleRate)));
+        smoothedLoad += (load - smoothedLoad) * coefficient;
+        smoothedVoices += ((float) activeVoices - smoothedVoices) * coefficient;
+
+        const float measured = load >= 1.0f ? juce::jmax(load, smoothedLoad) : smoothedLoad;
+
+        cap = getCap(maxVoices);
+
+        if (measured > targetLoad && activeVoices > 0)
+        {
+            // what each playing voice costs, and how many of them fit the target. An overload
+            // counted at once is set against the voices playing now.
+            const float voices = load >= 1.0f && load >= smoothedLoad ? (float) activeVoices : smoothedVoices;
+            const int fits = (int) (voices * targetLoad / measured);
+            cap = juce::jmax(juce::jmin(minimumVoices, maxVoices), juce::jmin(cap, fits));
+            headroomSamples = 0;
+        }
+        else if (measured < recoverLoad && cap < maxVoices)
+        {
+            headroomSamples += numSamples;
+
+            if (headroomSamples >= (int) (recoverSeconds * sampleRate))
+            {
+                ++cap;
+                headroomSamples = 0;
+            }
+        }
+        else
+        {
+            headroomSamples = 0;
+        }
+    }
+
+    float getSmoothedLoad() const noexcept { return smoothedLoad; }
+
+private:
+    double sampleRate = 44100.0;
+    int cap = std::numeric_limits<int>::max();
+    float smoothedLoad = 0.0f;
+    float smoothedVoices = 0.0f;                    // same pole as smoothedLoad
+    int headroomSamples = 0;
+};
@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    PluckVoiceManager.h
+
+    Which voice plays which note, and in what order they started. Replaces
+    the dynamic_cast scans over every voice on each note-on.
+
+      note table   MIDI note -> voice, for re-excites and note-offs. Each
+                   voice also keeps the channel it started on, MPE looks
+                   notes up by both (findVoice)
+      free list    stack of idle voices, the lowest index on top so a
+                   fresh synth hands out voices in the same order as
+                   juce::Synthesiser did
+      age list     playing voices linked oldest to newest. A re-excite
+                   moves its voice to the new end, stealing takes the
+                   old end. It's also the render order.
+
+    Every operation is O(1), bar the rare MPE case of one note playing on
+    several channels at once, which walks the age list. Tables are sized in prepare(), nothing here
+    allocates afterwards.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PluckVoiceManager
+{
+public:
+    static constexpr int numNotes = 128;
+
+    PluckVoiceManager() { noteVoice.fill(-1); }
+
+    // Not realtime safe, call before any notes come in.
+    void prepare(int numVoicesToUse)
+    {
+        numVoices = numVoicesToUse;
+        voiceNote.assign((size_t) numVoices, -1);
+        voiceChannel.assign((size_t) numVoices, 0);
+        older.assign((size_t) numVoices, -1);
+        newer.assign((size_t) numVoices, -1);
+        freeVoices.resize((size_t) numVoices);
+
+        reset();
+    }
+
+    // Every voice back to idle.
+    void reset() noexcept
+    {
+        std::fill(noteVoice.begin(), noteVoice.end(), -1);
+        std::fill(noteCount.begin(), noteCount.end(), 0);
+        std::fill(voiceNote.begin(), voiceNote.end(), -1);
+        std::fill(voiceChannel.begin(), voiceChannel.end(), 0);
+        std::fill(older.begin(), older.end(), -1);
+        std::fill(newer.begin(), newer.end(), -1);
+
+        for (int i = 0; i < numVoices; ++i)
+            freeVoices[(size_t) i] = numVoices - 1 - i;
+
+        numFree = numVoices;
+        oldest = newest = -1;
+    }
+
+    int getNumVoices() const noexcept { return numVoices; }
+    int getNumActive() const noexcept { return numVoices - numFree; }
+    bool hasFreeVoice() const noexcept { return numFree > 0; }
+
+    // -1 if the note isn't playing
+    int getVoiceForNote(int midiNote) const noexcept
+    {
+        return juce::isPositiveAndBelow(midiNote, numNotes) ? noteVoice[(size_t) midiNote] : -1;
+    }
+
+    // The voice playing midiNote on this channel, -1 if there's none. Two MPE channels can
+    // play the same note: the note table has the newest one, only then are the others walked.
+    int findVoice(int midiNote, int channel) const noexcept
+    {
+        const int voice = getVoiceForNote(midiNote);
+        if (voice < 0)
+            return -1;
+
+        if (voiceChannel[(size_t) voice] == channel)
+            return voice;
+
+        if (noteCount[(size_t) midiNote] < 2)
+            return -1;
+
+        for (int v = oldest; v >= 0; v = newer[(size_t) v])
+            if (voiceNote[(size_t) v] == midiNote && voiceChannel[(size_t) v] == channel)
+                return v;
+
+        return -1;
+    }
+
+    int getNoteForVoice(int voice) const noexcept { return voiceNote[(size_t) voice]; }
+    int getChannelForVoice(int voice) const noexcept { return voiceChannel[(size_t) voice]; }
+    bool isActive(int voice) const noexcept { return voiceNote[(size_t) voice] >= 0; }
+
+    // Takes a voice off the free list for midiNote and makes it the newest. -1 if none is free.
+    int allocate(int midiNote, int channel = 1) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(midiNote, numNotes));
+
+        if (numFree == 0)
+            return -1;
+
+        const int voice = freeVoices[(size_t) --numFree];
+
+        voiceNote[(size_t) voice] = midiNote;
+        voiceChannel[(size_t) voice] = channel;
+        noteVoice[(size_t) midiNote] = voice;
+        ++noteCount[(size_t) midiNote];
+        link(voice);
+
+        return voice;
+    }
+
+    // Back to the free list. Safe to call for a voice that's already free.
+    void release(int voice) noexcept
+    {
+        const int note = voiceNote[(size_t) voice];
+        if (note < 0)
+            return;
+
+        voiceNote[(size_t) voice] = -1;
+        unlink(voice);
+        freeVoices[(size_t) numFree++] = voice;
+
+        // another channel still playing this note (MPE) takes over its table entry
+        if (--noteCount[(size_t) note] == 0)
+            noteVoice[(size_t) note] = -1;
+        else if (noteVoice[(size_t) note] == voice)
+            noteVoice[(size_t) note] = findNewest(note);
+    }
+
+    // Makes a playing voice the newest, e.g. when its note is played again.
+    void touch(int voice) noexcept
+    {
+        if (! isActive(voice) || voice == newest)
+            return;
+
+        unlink(voice);
+        link(voice);
+    }
+
+    // Walk the playing voices oldest first: for (int v = getOldest(); v >= 0; v = getNewer(v)).
+    // Read getNewer() before releasing v.
+    int getOldest() const noexcept { return oldest; }
+    int getNewer(int voice) const noexcept { return newer[(size_t) voice]; }
+
+private:
+    int findNewest(int midiNote) const noexcept
+    {
+        for (int v = newest; v >= 0; v = older[(size_t) v])
+            if (voiceNote[(size_t) v] == midiNote)
+                return v;
+
+        return -1;
+    }
+
+    void link(int voice) noexcept
+    {
+        older[(size_t) voice] = newest;
+        newer[(size_t) voice] = -1;
+
+        if (newest >= 0)
+            newer[(size_t) newest] = voice;
+        else
+            oldest = voice;
+
+        newest = voice;
+    }
+
+    void unlink(int voice) noexcept
+    {
+        const int o = older[(size_t) voice];
+        const int n = newer[(size_t) voice];
+
+        if (o >= 0) newer[(size_t) o] = n; else oldest = n;
+        if (n >= 0) older[(size_t) n] = o; else newest = o;
+
+        older[(size_t) voice] = newer[(size_t) voice] = -1;
+    }
+
+    int numVoices = 0;
+    std::array<int, numNotes> noteVoice {};
+    std::array<int, numNotes> noteCount {};     // voices on each note, more than one only with MPE
+    std::vector<int> voiceNote, voiceChannel;
+
+    std::vector<int> freeVoices;
+    int numFree = 0;
+
+    std::vector<int> older, newer;
+    int oldest = -1, newest = -1;
+};
@@ -32,26 +32,30 @@ void PlucksAudioProcessorEditor::updatePageVisibility()
     if (maxVoicesFader) maxVoicesFader->setVisible(isSecondPage);
 
     tuningSelector.setVisible(isSecondPage);
+
+    // the telemetry readout is the only thing that changes on its own, and it's only on page two
+    if (isSecondPage)
+    {
+        shownTelemetry = audioProcessor.getTelemetry();
+        startTimerHz(10);
+    }
+    else
+        stopTimer();
 }
 
 // =================== Custom LookAndFeels ===================
 
-KnobLookAndFeel::KnobLookAndFeel()
-{
-    knobImage = juce::ImageCache::getFromMemory(BinaryData::Knob_png, BinaryData::Knob_pngSize);
-}
-
 void KnobLookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height,
                                        float sliderPosProportional, float rotaryStartAngle,
                                        float rotaryEndAngle, juce::Slider& slider)
 {
+    const auto knobImage = imageCache->getEmbedded(BinaryData::Knob_png, BinaryData::Knob_pngSize);
+
     if (knobImage.isValid())
     {
         auto bounds = juce::Rectangle<int>(x, y, width, height).toFloat();
         float angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
-        juce::Graphics::ScopedSaveState ss(g);
-        g.addTransform(juce::AffineTransform::rotation(angle, bounds.getCentreX(), bounds.getCentreY()));
-        g.drawImage(knobImage, bounds);
+        imageCache->drawRotated(g, knobImage, bounds, angle);
     }
     else
     {
@@ -60,26 +64,26 @@ void KnobLookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int widt
     }
 }
 
-SwitchLookAndFeel::SwitchLookAndFeel()
-{
-    switchImage = juce::ImageCache::getFromMemory(BinaryData::Switch_png, BinaryData::Switch_pngSize);
-}
-
 void SwitchLookAndFeel::drawToggleButton(juce::Graphics& g, juce::ToggleButton& button,
                                          bool shouldDrawButtonAsHighlighted, bool shouldDrawButtonAsDown)
 {
     auto bounds = button.getLocalBounds().toFloat();
 
-    if (switchImage.isValid())
+    if (switchOff.isNull())
     {
-        int stateWidth = switchImage.getWidth() / 2;
-        juce::Rectangle<int> srcRect = button.getToggleState()
-            ? juce::Rectangle<int>(stateWidth, 0, stateWidth, switchImage.getHeight())
-            : juce::Rectangle<int>(0, 0, stateWidth, switchImage.getHeight());
-
-        g.drawImage(switchImage,
-                    bounds.getX(), bounds.getY(), bounds.getWidth(), bounds.getHeight(),
-                    srcRect.getX(), srcRect.getY(), srcRect.getWidth(), srcRect.getHeight());
+        const auto switchImage = imageCache->getEmbedded(BinaryData::Switch_png, BinaryData::Switch_pngSize);
+
+        if (switchImage.isValid())
+        {
+            int stateWidth = switchImage.getWidth() / 2;
+            switchOff = switchImage.getClippedImage({ 0, 0, stateWidth, switchImage.getHeight() });
+            switchOn = switchImage.getClippedImage({ stateWidth, 0, stateWidth, switchImage.getHeight() });
+        }
+    }
+
+    if (switchOff.isValid())
+    {
+        imageCache->drawScaled(g, button.getToggleState() ? switchOn : switchOff, bounds);
     }
     else
     {
@@ -113,25 +117,32 @@ void PlucksAudioProcessorEditor::tuningSelectionChanged()
     {
         lastSelectedTuningId = selectedId;
 
-        // Only stop voices and change tuning if different
-        audioProcessor.stopAllVoicesGracefully();
+        // a program change or a loaded state moved the selector, the tuning came with it.
+        // Anything else is the user's, even if it matches what's playing: an earlier
+        // request may still be queued, and picking the custom entry again loads a new file.
+        if (audioProcessor.isFollowingProgram())
+            return;
+
+        // built on the tuning's loader thread and swapped in at a block boundary,
+        // playing notes glide over instead of being stopped
+        auto* tuning = audioProcessor.getTuningSystem();
 
         switch (selectedId)
         {
-            case 1: audioProcessor.getTuningSystem()->resetToEqualTemperament(); break;
-            case 2: audioProcessor.getTuningSystem()->setWellTemperament(); break;
-            case 3: audioProcessor.getTuningSystem()->setJustIntonation(); break;
-            case 4: audioProcessor.getTuningSystem()->setPythagorean(); break;
-            case 5: audioProcessor.getTuningSystem()->setMeantone(); break;
+            case 1: tuning->resetToEqualTemperament(); break;
+            case 2: tuning->setWellTemperament(); break;
+            case 3: tuning->setJustIntonation(); break;
+            case 4: tuning->setPythagorean(); break;
+            case 5: tuning->setMeantone(); break;
             case 6:
             {
                 if (tunFileChooser != nullptr)
                     return; // Dialog already open, prevent opening another
 
                 tunFileChooser = std::make_unique<juce::FileChooser>(
-                    "Select a .tun tuning file",
+                    "Select a .tun or Scala .scl tuning file (a .kbm of the same name is picked up too)",
                     juce::File::getSpecialLocation(juce::File::userHomeDirectory),
-                    "*.tun"
+                    "*.tun;*.scl"
                 );
 
                 tunFileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
@@ -140,17 +151,26 @@ void PlucksAudioProcessorEditor::tuningSelectionChanged()
                         auto file = fc.getResult();
                         if (file.exists())
                         {
-                            if (audioProcessor.getTuningSystem()->loadTuningFile(file))
-                            {
-                                tuningSelector.setText(audioProcessor.getTuningSystem()->getCurrentTuningName());
-                            }
-                            else
+                            // the file is read on the loader thread, not in this callback
+                            juce::Component::SafePointer<PlucksAudioProcessorEditor> safeThis(this);
+
+                            audioProcessor.getTuningSystem()->loadTuningFile(file, [safeThis](bool succeeded)
                             {
-                                juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
-                                                                    "Error",
-                                                                    "Failed to load tuning file. Please check the file format.");
-                                tuningSelector.setSelectedId(1);
-                            }
+                                if (safeThis == nullptr)
+                                    return;
+
+                                if (succeeded)
+                                {
+                                    safeThis->tuningSelector.setText(safeThis->audioProcessor.getTuningSystem()->getCurrentTuningName());
+                                }
+                                else
+                                {
+                                    juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
+                                                                        "Error",
+                                                                        "Failed to load tuning file. Please check the file format.");
+                                    safeThis->tuningSelector.setSelectedId(1);
+                                }
+                            });
                         }
                         else
                         {
@@ -170,7 +190,10 @@ void PlucksAudioProcessorEditor::tuningSelectionChanged()
 PlucksAudioProcessorEditor::PlucksAudioProcessorEditor (PlucksAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p), tooltipWindow(this, 500)
 {
+    const auto startTicks = PluckTelemetry::now();
+
     setSize (600, 400);
+    setOpaque(true); // the background covers everything, nothing behind the editor needs painting
     currentPage = GuiPage::Main;  // explicit initialization
 
     // 1. Sliders: use graphical knob
@@ -205,44 +228,8 @@ PlucksAudioProcessorEditor::PlucksAudioProcessorEditor (PlucksAudioProcessor& p)
     stereoButton.setLookAndFeel(&switchLNF);
     addAndMakeVisible(stereoButton);
 
-    fineTuneFader = std::make_unique<ImageFader>(audioProcessor.parameters, "FINETUNE", "Fine Tune", faderLNF);
-    stereoMicrotuneFader = std::make_unique<ImageFader>(audioProcessor.parameters, "STEREOMICROTUNECENTS", "Stereo Detune", faderLNF);
-    gateDampingFader = std::make_unique<ImageFader>(audioProcessor.parameters, "GATEDAMPING", "Gate Tail", faderLNF);
-    exciterSlewRateFader = std::make_unique<ImageFader>(audioProcessor.parameters, "EXCITERSLEWRATE", "Exciter Slew", faderLNF);
-    maxVoicesFader = std::make_unique<ImageFader>(audioProcessor.parameters, "MAXVOICES", "Voices", faderLNF);
+    // 3. Second page faders and tuning selector: see buildSecondPage()
 
-    setupTuningSelector();
-    
-    addAndMakeVisible(fineTuneFader->slider);
-    addAndMakeVisible(fineTuneFader->nameLabel);
-    addAndMakeVisible(fineTuneFader->valueLabel);
-    
-    addAndMakeVisible(stereoMicrotuneFader->slider);
-    addAndMakeVisible(stereoMicrotuneFader->nameLabel);
-    addAndMakeVisible(stereoMicrotuneFader->valueLabel);
-
-    addAndMakeVisible(gateDampingFader->slider);
-    addAndMakeVisible(gateDampingFader->nameLabel);
-    addAndMakeVisible(gateDampingFader->valueLabel);
-
-    addAndMakeVisible(exciterSlewRateFader->slider);
-    addAndMakeVisible(exciterSlewRateFader->nameLabel);
-    addAndMakeVisible(exciterSlewRateFader->valueLabel);
-
-    addAndMakeVisible(maxVoicesFader->slider);
-    addAndMakeVisible(maxVoicesFader->nameLabel);
-    addAndMakeVisible(maxVoicesFader->valueLabel);
-
-    fineTuneFader->setVisible(false);
-    stereoMicrotuneFader->setVisible(false);
-    gateDampingFader->setVisible(false);
-    exciterSlewRateFader->setVisible(false);
-    maxVoicesFader->setVisible(false);
-
-    // 3. Background image
-    backgroundImage = juce::ImageCache::getFromMemory(BinaryData::Background_png, BinaryData::Background_pngSize);
-    background2Image = juce::ImageCache::getFromMemory(BinaryData::Background2_png, BinaryData::Background2_pngSize);
-    
     // 4. Attachments
     decayAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.parameters, "DECAY", decaySlider);
@@ -255,10 +242,8 @@ PlucksAudioProcessorEditor::PlucksAudioProcessorEditor (PlucksAudioProcessor& p)
     stereoAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
         audioProcessor.parameters, "STEREO", stereoButton);
 
-    startTimerHz(10); // repaint 10 times per second
-
     // InfoOverlayImage = juce::ImageCache::getFromMemory(BinaryData::Info_png, BinaryData::Info_pngSize);
-    buttonOverlayImage = juce::ImageCache::getFromMemory(BinaryData::Button_png, BinaryData::Button_pngSize);
+    buttonOverlayImage = imageCache->getEmbedded(BinaryData::Button_png, BinaryData::Button_pngSize);
 
     // Set the button rectangle size (dynamic from button image size)
     // but allow any place in upper left corner also
@@ -268,11 +253,48 @@ PlucksAudioProcessorEditor::PlucksAudioProcessorEditor (PlucksAudioProcessor& p)
     // finetuneSlider.setTooltip("FineTune Cents");
     updatePageVisibility();  // This ensures correct visibility on startup.
     resized();
+
+    audioProcessor.startupStepTook(PluckTelemetry::StartupStep::editor, startTicks);
+}
+
+void PlucksAudioProcessorEditor::buildSecondPage()
+{
+    if (fineTuneFader != nullptr)
+        return;
+
+    const auto startTicks = PluckTelemetry::now();
+
+    fineTuneFader = std::make_unique<ImageFader>(audioProcessor.parameters, "FINETUNE", "Fine Tune", faderLNF);
+    stereoMicrotuneFader = std::make_unique<ImageFader>(audioProcessor.parameters, "STEREOMICROTUNECENTS", "Stereo Detune", faderLNF);
+    gateDampingFader = std::make_unique<ImageFader>(audioProcessor.parameters, "GATEDAMPING", "Gate Tail", faderLNF);
+    exciterSlewRateFader = std::make_unique<ImageFader>(audioProcessor.parameters, "EXCITERSLEWRATE", "Exciter Slew", faderLNF);
+    maxVoicesFader = std::make_unique<ImageFader>(audioProcessor.parameters, "MAXVOICES", "Voices", faderLNF);
+
+    setupTuningSelector();
+
+    for (auto* fader : { fineTuneFader.get(), stereoMicrotuneFader.get(), gateDampingFader.get(),
+                         exciterSlewRateFader.get(), maxVoicesFader.get() })
+    {
+        addChildComponent(fader->slider);
+        addChildComponent(fader->nameLabel);
+        addChildComponent(fader->valueLabel);
+    }
+
+    resized();
+
+    audioProcessor.startupStepTook(PluckTelemetry::StartupStep::secondPage, startTicks);
 }
 
 void PlucksAudioProcessorEditor::timerCallback()
 {
-    repaint();
+    // controls repaint themselves when their values move, only the readout is polled
+    const auto t = audioProcessor.getTelemetry();
+
+    if (t.blocks != shownTelemetry.blocks || t.activeVoices != shownTelemetry.activeVoices)
+    {
+        shownTelemetry = t;
+        repaint(telemetryBounds);
+    }
 }
 
 PlucksAudioProcessorEditor::~PlucksAudioProcessorEditor()
@@ -300,23 +322,69 @@ void PlucksAudioProcessorEditor::paint(juce::Graphics& g)
     switch (currentPage)
     {
         case GuiPage::Main:
-            g.drawImage(backgroundImage, getLocalBounds().toFloat());
-            if (buttonOverlayImage.isValid())
-                g.drawImage(buttonOverlayImage, buttonBounds.toFloat());
+            imageCache->drawScaled(g, imageCache->getEmbedded(BinaryData::Background_png, BinaryData::Background_pngSize),
+                                   getLocalBounds().toFloat());
+            imageCache->drawScaled(g, buttonOverlayImage, buttonBounds.toFloat());
 
             // Draw active voices info, etc
             break;
 
         case GuiPage::SecondPage:
-            g.drawImage(background2Image, getLocalBounds().toFloat());
-            if (buttonOverlayImage.isValid())
-                g.drawImage(buttonOverlayImage, buttonBounds.toFloat());
+            imageCache->drawScaled(g, imageCache->getEmbedded(BinaryData::Background2_png, BinaryData::Background2_pngSize),
+                                   getLocalBounds().toFloat());
+            imageCache->drawScaled(g, buttonOverlayImage, buttonBounds.toFloat());
 
-            // Draw active voices info, etc
+            paintTelemetry(g);
             break;
     }
 }
 
+void PlucksAudioProcessorEditor::paintTelemetry(juce::Graphics& g)
+{
+    const auto& t = shownTelemetry;
+    auto area = telemetryBounds;
+
+    // load histogram on the right, one bar per 10% of the deadline, the last one is overloads
+    auto histogram = area.removeFromRight(110).reduced(0, 8);
+    const auto mostBlocks = juce::jmax(1u, *std::max_element(t.loadHistogram.begin(), t.loadHistogram.end()));
+    const float barWidth = (float) histogram.getWidth() / (float) PluckTelemetry::numLoadBuckets;
+
+    for (int i = 0; i < PluckTelemetry::numLoadBuckets; ++i)
+    {
+        const auto count = t.loadHistogram[(size_t) i];
+        if (count == 0)
+            continue;
+
+        // log scale, a handful of slow blocks should still show up next to millions of fast ones
+        const float h = (float) histogram.getHeight() * (float) (std::log1p((double) count) / std::log1p((double) mostBlocks));
+        g.setColour(i == PluckTelemetry::numLoadBuckets - 1 ? juce::Colours::darkred : juce::Colours::black);
+        g.fillRect(juce::Rectangle<float>((float) histogram.getX() + (float) i * barWidth, (float) histogram.getBottom() - h,
+                                          barWidth - 1.0f, h));
+    }
+
+    g.setColour(juce::Colours::black);
+    g.setFont(juce::Font(juce::FontOptions().withHeight(13.0f)));
+
+    const juce::String lines[] =
+    {
+        "CPU " + juce::String(t.lastLoad * 100.0f, 1) + "%  peak " + juce::String(t.peakLoad * 100.0f, 1)
+            + "%  overloads " + juce::String(t.overloads) + " / " + juce::String(t.blocks) + " blocks",
+        "voices " + juce::String(t.activeVoices) + (t.voiceCap > 0 ? " / " + juce::String(t.voiceCap) : juce::String())
+            + "  peak " + juce::String(t.peakVoices) + "  steals " + juce::String(t.steals) + "  re-excites " + juce::String(t.reExcites),
+        "ended: silence " + juce::String(t.silenceEnds) + "  timer " + juce::String(t.timerEnds)
+            + "  shed " + juce::String(t.sheds) + "  MIDI dropped " + juce::String(t.droppedMidiEvents),
+        "note-on worst " + juce::String(t.worstNoteOnMicroseconds, 1) + " us  render "
+            + juce::String(t.renderNanosPerVoiceSample, 1) + " ns/voice/sample",
+        "startup ms: voices " + juce::String(t.startupMilliseconds[0], 2) + "  prepare " + juce::String(t.startupMilliseconds[1], 2)
+            + "  editor " + juce::String(t.startupMilliseconds[2], 2) + "  page two " + juce::String(t.startupMilliseconds[3], 2)
+    };
+
+    const int lineHeight = area.getHeight() / (int) std::size(lines);
+
+    for (const auto& line : lines)
+        g.drawText(line, area.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+}
+
 void PlucksAudioProcessorEditor::resized()
 {
     DBG("resized() called");
@@ -356,6 +424,10 @@ void PlucksAudioProcessorEditor::resized()
 
 void PlucksAudioProcessorEditor::showSecondPageControls(bool show)
 {
+    if (show)
+        buildSecondPage();
+    else if (fineTuneFader == nullptr)
+        return;
 
     fineTuneFader->slider.setVisible(show);
     stereoMicrotuneFader->slider.setVisible(show);
@@ -372,6 +444,7 @@ void PlucksAudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
         if (currentPage == GuiPage::Main)
         {
             currentPage = GuiPage::SecondPage;
+            buildSecondPage();
             
             // Hide main controls
             decaySlider.setVisible(false);
@@ -441,5 +514,12 @@ void PlucksAudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
         repaint();
         return;
     }
+
+    if (currentPage == GuiPage::SecondPage && telemetryBounds.contains(event.getPosition()))
+    {
+        audioProcessor.resetTelemetry();
+        return;
+    }
+
     AudioProcessorEditor::mouseDown(event);
 }
\ No newline at end of file
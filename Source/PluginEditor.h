@@ -3,57 +3,46 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "TuningSystem.h"
+#include "PluckImageCache.h"
 
 
 
+// The look and feels decode their images on first draw, from the shared PluckImageCache
 class KnobLookAndFeel : public juce::LookAndFeel_V4
 {
 public:
-    KnobLookAndFeel();
     void drawRotarySlider (juce::Graphics& g, int x, int y, int width, int height,
                            float sliderPosProportional, float rotaryStartAngle,
                            float rotaryEndAngle, juce::Slider& slider) override;
 private:
-    juce::Image knobImage;
+    juce::SharedResourcePointer<PluckImageCache> imageCache;
 };
 
 // Custom LookAndFeel for switches
 class SwitchLookAndFeel : public juce::LookAndFeel_V4
 {
 public:
-    SwitchLookAndFeel();
     void drawToggleButton(juce::Graphics& g, juce::ToggleButton& button,
                           bool shouldDrawButtonAsHighlighted, bool shouldDrawButtonAsDown) override;
 private:
-    juce::Image switchImage;
+    juce::Image switchOff, switchOn;  // the two halves, cut once so the cache sees the same images every paint
+    juce::SharedResourcePointer<PluckImageCache> imageCache;
 };
 
 class FaderLookAndFeel : public juce::LookAndFeel_V4
 {
 public:
-    FaderLookAndFeel()
-    {
-        faderTrack = juce::ImageCache::getFromMemory(BinaryData::FaderTrack_png, BinaryData::FaderTrack_pngSize);
-        faderKnob  = juce::ImageCache::getFromMemory(BinaryData::FaderKnob_png, BinaryData::FaderKnob_pngSize);
-        
-        // Debug output to verify images loaded
-        DBG("FaderTrack valid: " << (faderTrack.isValid() ? "Yes" : "No"));
-        DBG("FaderKnob valid: " << (faderKnob.isValid() ? "Yes" : "No"));
-        if (faderTrack.isValid())
-            DBG("FaderTrack size: " << faderTrack.getWidth() << "x" << faderTrack.getHeight());
-        if (faderKnob.isValid())
-            DBG("FaderKnob size: " << faderKnob.getWidth() << "x" << faderKnob.getHeight());
-    }
-
     void drawLinearSlider(juce::Graphics& g, int x, int y, int width, int height,
                           float sliderPos, float minSliderPos, float maxSliderPos,
                           const juce::Slider::SliderStyle, juce::Slider& slider) override
     {
+        const auto faderTrack = imageCache->getEmbedded(BinaryData::FaderTrack_png, BinaryData::FaderTrack_pngSize);
+        const auto faderKnob  = imageCache->getEmbedded(BinaryData::FaderKnob_png, BinaryData::FaderKnob_pngSize);
+
         // Draw fader track background (scaled to full slider bounds)
         if (faderTrack.isValid())
         {
-            g.drawImage(faderTrack, (float)x, (float)y, (float)width, (float)height, 
-                       0, 0, faderTrack.getWidth(), faderTrack.getHeight());
+            imageCache->drawScaled(g, faderTrack, juce::Rectangle<int>(x, y, width, height).toFloat());
         }
         else
         {
@@ -75,8 +64,7 @@ public:
             // Clamp knob position to stay within slider bounds
             knobX = juce::jlimit((float)x, (float)(x + width - knobW), knobX);
             
-            g.drawImage(faderKnob, knobX, knobY, (float)knobW, (float)knobH, 
-                       0, 0, knobW, knobH);
+            imageCache->drawScaled(g, faderKnob, { knobX, knobY, (float)knobW, (float)knobH });
         }
         else
         {
@@ -94,7 +82,7 @@ public:
     }
 
 private:
-    juce::Image faderTrack, faderKnob;
+    juce::SharedResourcePointer<PluckImageCache> imageCache;
 };
 
 struct ImageFader
@@ -221,6 +209,10 @@ private:
 
     juce::Rectangle<int> buttonBounds; // for click detection
 
+    // second page: CPU / voice readout from the processor's telemetry, click to reset
+    juce::Rectangle<int> telemetryBounds { 125, 230, 450, 80 };
+    void paintTelemetry(juce::Graphics& g);
+
     juce::TooltipWindow tooltipWindow;
 
     PlucksAudioProcessor& audioProcessor;
@@ -234,6 +226,9 @@ private:
     void setupTuningSelector();
     void tuningSelectionChanged();
 
+    // the faders and the tuning selector, made the first time the second page is shown
+    void buildSecondPage();
+
     const TuningSystem* tuningSystem = nullptr;
     int lastSelectedTuningId = 1; // or whatever initial tuning ID you have
     std::unique_ptr<juce::FileChooser> tunFileChooser;
@@ -258,8 +253,9 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> gateAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> stereoAttachment;
     
-    juce::Image backgroundImage;
-    juce::Image background2Image;
+    // pre-scaled backgrounds, knob frames and fader parts, shared by every open editor
+    juce::SharedResourcePointer<PluckImageCache> imageCache;
+    PluckTelemetry::Snapshot shownTelemetry;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlucksAudioProcessorEditor)
 };
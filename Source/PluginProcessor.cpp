@@ -1,27 +1,49 @@
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+#if ! PLUCKS_HEADLESS
+ #include "PluginEditor.h"
+#endif
 #include "PluckVoice.h"
-#include "PluckSound.h"
 
 //==============================================================================
 PlucksAudioProcessor::PlucksAudioProcessor()
     : AudioProcessor(BusesProperties().withOutput("Output", juce::AudioChannelSet::stereo(), true)),
     parameters(*this, nullptr, "PARAMETERS", createParameterLayout()),
-    voiceCounter(0)  // Initialize voice counter for age tracking
+    parameterCache(parameters),
+    blockParameters(parameterCache.load())
 {
+    const auto startTicks = PluckTelemetry::now();
+
+    maxVoicesAllowed = blockParameters.maxVoices;
+    blockParameters.noiseSeed = getEffectiveNoiseSeed();
+    blockParameters.updateDelayScales();
+
     // Add voices
     for (int i = 0; i < 36; ++i) // don't need 36 voices because: Re-excitement
     {
-        synth.addVoice(new PluckVoice(parameters));
-        voiceAges.push_back(0);  // Initialize voice ages
+        auto* voice = new PluckVoice(blockParameters);
+        voice->setNoiseStream(i);
+        voice->setExciterBank(&exciterBank);
+        voice->setCoefficientTable(&coefficientTable);
+        synth.addVoice(voice);
     }
-    
-    // Add a dummy sound (required by JUCE to trigger voices)
-    synth.addSound(new PluckSound());
+
+    // the programs, tuning tables and all
+    presetBank.build(*this, tuningSystem);
+
+    // SIMD string bank, one lane pair per voice, and the note -> voice tables
+    synth.prepareVoiceBank();
+    synth.setVoiceLimit(maxVoicesAllowed);
+    synth.setTelemetry(&telemetry);
+
+    // program changes applied in processBlock reach the host from here
+    startTimerHz(programNotifyHz);
+
+    telemetry.startupStepTook(PluckTelemetry::StartupStep::voices, startTicks);
 }
 
 PlucksAudioProcessor::~PlucksAudioProcessor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -64,32 +86,86 @@ double PlucksAudioProcessor::getTailLengthSeconds() const
 
 int PlucksAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return juce::jmax(1, presetBank.size());   // NB: some hosts don't cope very well if you tell them there are 0 programs
 }
 
 int PlucksAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    const int requested = requestedProgram.load();
+    return requested >= 0 ? requested : currentProgram.load();
 }
 
 void PlucksAudioProcessor::setCurrentProgram (int index)
 {
+    if (! presetBank.contains(index))
+        return;
+
+    // with the audio off there's no block to wait for
+    if (! prepared.load())
+    {
+        requestedProgram.store(-1);
+        applyProgram(index);
+
+        // the host and the editor see it before this returns
+        if (juce::MessageManager::existsAndIsCurrentThread())
+            notifyProgramChange();
+
+        return;
+    }
+
+    requestedProgram.store(index);
 }
 
 const juce::String PlucksAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return presetBank.getName(index);
 }
 
 void PlucksAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    presetBank.setName(index, newName);
+}
+
+bool PlucksAudioProcessor::applyProgram(int index)
+{
+    currentProgram.store(index);
+    const bool retuned = presetBank.apply(index, tuningSystem);
+
+    programToNotify.store(index);
+    return retuned;
+}
+
+void PlucksAudioProcessor::notifyProgramChange()
+{
+    const int program = programToNotify.exchange(-1);
+
+    if (program >= 0)
+    {
+        const juce::ScopedValueSetter<bool> following(followingProgram, true);
+        presetBank.notifyHost(program);
+        updateHostDisplay(ChangeDetails().withProgramChanged(true));
+    }
 }
 
 void PlucksAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    prepared.store(false);
+    exciterBank.stopBackgroundBuilds();
+    synth.prepareRenderThreads(0, 0);
+}
+
+void PlucksAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime(isNonRealtime);
+
+    // hosts can switch without a new prepareToPlay, the exciter bank builds in processBlock
+    // only once its thread has stopped
+    if (isNonRealtime)
+        exciterBank.stopBackgroundBuilds();
+    else if (prepared.load())
+        exciterBank.startBackgroundBuilds();
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout PlucksAudioProcessor::createParameterLayout()
@@ -146,6 +222,12 @@ juce::AudioProcessorValueTreeState::ParameterLayout PlucksAudioProcessor::create
         16    // default integer value
     ));
 
+    // under CPU load, fade out the quietest voices rather than miss the deadline
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID { "ADAPTIVEVOICES", 1 },
+        "Adaptive Voices",
+        false));
+
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID { "GATEDAMPING", 1 },
         "Gate Damping", 
@@ -194,160 +276,162 @@ bool PlucksAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
 
 void PlucksAudioProcessor::prepareToPlay(double sampleRate, int maxBlockSize)
 {
+    const auto startTicks = PluckTelemetry::now();
+
     currentSampleRate = sampleRate;
     synth.setCurrentPlaybackSampleRate(sampleRate);
 
-    juce::dsp::ProcessSpec spec{ sampleRate, static_cast<juce::uint32>(maxBlockSize), 1 };
+    // every note's string period at this rate, voices only look them up
+    tuningSystem.prepare(sampleRate);
+    presetBank.prepare(sampleRate);
+
+    // one block for every string ring and exciter, sized for this rate and our lowest note
+    synth.prepareVoiceMemory(sampleRate, lowestNote);
+
+    // workers get scratch for a whole block, the synth renders on the audio thread alone past that
+    synth.prepareRenderThreads(renderThreads.load(), maxBlockSize);
+
+    // offline renders build exciter tables in processBlock instead, so they come out the same every time
+    if (isNonRealtime())
+        exciterBank.stopBackgroundBuilds();
+    else
+        exciterBank.startBackgroundBuilds();
+
+    // restart the noise streams, a seeded render then always starts from the same place
+    blockParameters.noiseSeed = getEffectiveNoiseSeed();
 
     for (int i = 0; i < synth.getNumVoices(); ++i)
     {
-        if (auto* voice = dynamic_cast<PluckVoice*>(synth.getVoice(i)))
-        {
-            voice->setCurrentPlaybackSampleRate(sampleRate);
-            
-            // Set tuning system reference
-            voice->setTuningSystem(&tuningSystem);
-
+        auto* voice = synth.getVoice(i);
 
-            // Existing delay line preparation code...
-            voice->getLeftDelayLine().reset();
-            voice->getLeftDelayLine().prepare(spec);
-            voice->getLeftDelayLine().setMaximumDelayInSamples(PluckVoice::getMaxBufferSize() - 1);
+        // Set tuning system reference
+        voice->setTuningSystem(&tuningSystem);
 
-            voice->getRightDelayLine().reset();
-            voice->getRightDelayLine().prepare(spec);
-            voice->getRightDelayLine().setMaximumDelayInSamples(PluckVoice::getMaxBufferSize() - 1);
+        // string rings are in the arena, each note sizes its own ring
+        voice->getLeftDelayLine().reset();
+        voice->getRightDelayLine().reset();
 
-            voice->getSmoothedDelayL().reset(sampleRate, 0.02f);
-            voice->getSmoothedDelayR().reset(sampleRate, 0.02f);
+        voice->getSmoothedDelayL().reset(sampleRate, 0.02f);
+        voice->getSmoothedDelayR().reset(sampleRate, 0.02f);
 
-            voice->resetBuffers();
-            voice->clearCurrentNote();
-        }
+        voice->resetNoise();
     }
+
+    synth.stopAllVoices();
+    telemetry.reset();
+    voiceBudget.prepare(sampleRate);
+    telemetry.startupStepTook(PluckTelemetry::StartupStep::prepare, startTicks);
+
+    prepared.store(true);
 }
 
 void PlucksAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    const auto blockStart = PluckTelemetry::now();
+    telemetry.beginBlock();
+
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    // Update parameters for all voices (keep your existing parameter code)
-    bool gateEnabled = parameters.getRawParameterValue("GATE")->load();
-    bool stereoEnabled = parameters.getRawParameterValue("STEREO")->load();
-    float newFineTuneCents = parameters.getRawParameterValue("FINETUNE")->load(); 
-    float newDecay = parameters.getRawParameterValue("DECAY")->load(); 
-    float newDamp = parameters.getRawParameterValue("DAMP")->load(); 
-    float newColor = parameters.getRawParameterValue("COLOR")->load(); 
-    maxVoicesAllowed = parameters.getRawParameterValue("MAXVOICES")->load(); // used in processblock
-    float newStereoMicrotuneCents = parameters.getRawParameterValue("STEREOMICROTUNECENTS")->load();
-    float newExciterSlewRate = parameters.getRawParameterValue("EXCITERSLEWRATE")->load(); 
-    float newDampingCurve = parameters.getRawParameterValue("DAMPINGCURVE")->load(); 
-
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-    {
-        if (auto* pluckVoice = dynamic_cast<PluckVoice*>(synth.getVoice(i)))
-        {
-            pluckVoice->setGateEnabled(gateEnabled);
-            pluckVoice->setStereoEnabled(stereoEnabled);
-            pluckVoice->setFineTuneCents(newFineTuneCents);
-            pluckVoice->setCurrentDecay(newDecay);
-            pluckVoice->setCurrentDamp(newDamp);
-            pluckVoice->setCurrentColor(newColor);
-            pluckVoice->setStereoMicrotuneCents(newStereoMicrotuneCents);
-            pluckVoice->setExciterSlewRate(newExciterSlewRate);
-            pluckVoice->setDampingCurve(newDampingCurve);
-        }
-    }
+    // decoded straight into the preallocated queue, nothing on the heap however dense the MIDI
+    midiQueue.clear();
+    int program = requestedProgram.exchange(-1);
 
-    juce::MidiBuffer filteredMidi;
-    
     for (const auto metadata : midiMessages)
     {
-        auto message = metadata.getMessage();
-        
-        if (message.isNoteOn())
-        {
-            int midiNote = message.getNoteNumber();
-            
-            // Reject notes below C1 (MIDI 24)
-            if (midiNote < 12 || midiNote > 108)
-                continue;
-
-            float velocity = message.getFloatVelocity();
-            bool voiceFound = false;
-            
-            // First, check for re-excitation of existing notes (keep your existing logic)
-            for (int i = 0; i < synth.getNumVoices(); ++i)
-            {
-                if (auto* pluckVoice = dynamic_cast<PluckVoice*>(synth.getVoice(i)))
-                {
-                    if (pluckVoice->isPlayingNote() && pluckVoice->getCurrentlyPlayingNote() == midiNote)
-                    {
-                        if (gateEnabled)
-                        {
-                            // Gate mode: immediately clear this voice and retrigger fresh
-                            pluckVoice->clearCurrentNote();
-                            pluckVoice->resetBuffers();
-
-                            filteredMidi.addEvent(message, metadata.samplePosition); // add new note event to retrigger
-                        }
-                        else
-                        {
-                            // Non-gate mode: schedule re-excite
-                            pluckVoice->scheduleReExcite(metadata.samplePosition, velocity);
-                        }
-
-                        voiceAges[i] = ++voiceCounter;
-                        voiceFound = true;
-                        break;
-                    }
-                }
-            }
-            
-            // ==== probably not perfect. may be edge cases of missed notes. let's keep our eyes peeled.
-            if (!voiceFound)
-            {
-                // Check if we're at max polyphony
-                int activeVoices = getNumActiveVoices();
-                if (activeVoices >= maxVoicesAllowed)  // Max polyphony reached
-                {
-                    // Find oldest voice to steal
-                    int voiceToSteal = findOldestVoice();  
-                    if (voiceToSteal != -1)
-                    {
-                        if (auto* voice = dynamic_cast<PluckVoice*>(synth.getVoice(voiceToSteal)))
-                        {
-                            // Hard stop the old voice
-                            voice->clearCurrentNote();
-                            voice->resetBuffers();
-                        }
-                    }
-                }
-                // Let JUCE handle the new note normally
-                filteredMidi.addEvent(message, metadata.samplePosition);
-                // Find which voice will get this note and update its age
-                updateVoiceAgeForNewNote(midiNote);
-            }
-        }
-        else
+        const auto event = PluckMidiQueue::decode(metadata.data, metadata.numBytes, metadata.samplePosition);
+
+        // Reject notes below C0 (MIDI 12), the voice arena isn't sized for them
+        if (event.type == PluckMidiQueue::Type::noteOn && (event.note < lowestNote || event.note > highestNote))
+            continue;
+
+        // the block's last one wins, applied before anything reads the parameters
+        if (event.type == PluckMidiQueue::Type::programChange)
         {
-            // Pass other messages untouched (keep your existing logic)
-            filteredMidi.addEvent(message, metadata.samplePosition);
+            if (presetBank.contains(event.value))
+                program = event.value;
+
+            continue;
         }
+
+        midiQueue.add(event);
     }
 
-    synth.renderNextBlock(buffer, filteredMidi, 0, buffer.getNumSamples());
+    telemetry.midiEventsDropped(midiQueue.takeNumDropped());
+
+    const bool programRetuned = program >= 0 && applyProgram(program);
+
+    // Snapshot the parameters once per block. Voices that start during this block read the
+    // snapshot themselves, so only playing voices need the fields that changed pushed in.
+    const PluckParameters previousParameters = blockParameters;
+    blockParameters = parameterCache.load();
+    blockParameters.updateDelayScales(previousParameters);
+    blockParameters.noiseSeed = getEffectiveNoiseSeed();
+    blockParameters.stringInterpolation = static_cast<int>(stringInterpolation.load());
+    blockParameters.silenceFloorDb = silenceFloorDb.load();
+    blockParameters.noteTimer = noteTimer.load();
+
+    // a tuning loaded (or a program changed) since the last block goes live here,
+    // playing notes glide over to it
+    if (tuningSystem.beginBlock() || programRetuned)
+        synth.forEachActiveVoice([](PluckVoice& voice) { voice.retune(); });
+
+    PluckExciterBank::Config exciterConfig;
+    exciterConfig.sampleRate = currentSampleRate;
+    exciterConfig.delayScaleL = blockParameters.delayScaleL;
+    exciterConfig.delayScaleR = blockParameters.delayScaleR;
+    exciterConfig.color = blockParameters.color;
+    exciterConfig.exciterSlewRate = blockParameters.exciterSlewRate;
+    exciterConfig.stereo = blockParameters.stereoEnabled;
+    exciterConfig.noiseSeed = blockParameters.noiseSeed;
+    exciterConfig.tuningVersion = tuningSystem.getVersion();
+    tuningSystem.getPeriods(currentSampleRate, exciterConfig.periods);
+    exciterBank.update(exciterConfig, isNonRealtime());
+
+    // per-note feedback / note timer and the damping values, before any voice reads them
+    coefficientTable.update(blockParameters, currentSampleRate, &tuningSystem);
+
+    const bool gateEnabled = blockParameters.gateEnabled;
+    maxVoicesAllowed = blockParameters.maxVoices; // used in processblock
+
+    // ADAPTIVEVOICES: the cap can sit under MAXVOICES while the CPU is short, and the quietest
+    // voices go first. Offline renders have no deadline to miss, so they never adapt.
+    const bool adaptiveVoices = blockParameters.adaptiveVoices && ! isNonRealtime();
+    if (! adaptiveVoices)
+        voiceBudget.reset();
+
+    const int voiceCap = adaptiveVoices ? voiceBudget.getCap(maxVoicesAllowed) : maxVoicesAllowed;
+
+    if (const auto changed = blockParameters.getChangedFields(previousParameters))
+        synth.forEachActiveVoice([&](PluckVoice& voice) { voice.applyParameters(blockParameters, changed); });
+
+    // re-excite vs. retrigger and stealing happen in the synth when it reaches each note
+    synth.setGateEnabled(gateEnabled);
+    synth.setVoiceLimit(voiceCap, voiceCap < maxVoicesAllowed);
+    synth.setMpeEnabled(mpeEnabled.load());
+    synth.setPitchBendRange(pitchBendRange.load());
+
+    // over the cap: fade the extra voices out rather than let the block run late
+    if (voiceCap < maxVoicesAllowed)
+        synth.shedVoices(voiceCap);
+
+    synth.renderNextBlock(buffer, midiQueue, 0, buffer.getNumSamples());
 
     float* leftChannel = buffer.getWritePointer(0);
     float* rightChannel = totalNumOutputChannels > 1 ? buffer.getWritePointer(1) : leftChannel;
 
     float gain = 0.3f;
     buffer.applyGain(gain);
+
+    const float load = telemetry.endBlock(blockStart, buffer.getNumSamples(), currentSampleRate, synth.getNumActiveVoices(),
+                                          adaptiveVoices ? voiceCap : 0);
+
+    if (adaptiveVoices)
+        voiceBudget.endBlock(load, synth.getNumActiveVoices(), buffer.getNumSamples(), maxVoicesAllowed);
 }
 
 void PlucksAudioProcessor::setMaxVoicesAllowed(int newMax)
@@ -355,100 +439,120 @@ void PlucksAudioProcessor::setMaxVoicesAllowed(int newMax)
     maxVoicesAllowed = std::clamp(newMax, 1, (int)synth.getNumVoices());
 }
 
-int PlucksAudioProcessor::findOldestVoice()
+int PlucksAudioProcessor::getNumActiveVoices() const
 {
-    int oldestVoice = -1;
-    uint64_t oldestAge = UINT64_MAX;
-    
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-    {
-        if (auto* voice = dynamic_cast<PluckVoice*>(synth.getVoice(i)))
-        {
-            if (voice->isPlayingNote())  // Only consider active voices
-            {
-                if (voiceAges[i] < oldestAge)
-                {
-                    oldestAge = voiceAges[i];
-                    oldestVoice = i;
-                }
-            }
-        }
-    }
-    
-    return oldestVoice;
+    return synth.getNumActiveVoices();
 }
 
-// Update age when a new note starts
-void PlucksAudioProcessor::updateVoiceAgeForNewNote(int midiNote)
+void PlucksAudioProcessor::stopAllVoicesGracefully()
 {
-    // Find which voice will handle this note and update its age
-    // This is called after adding the note to filteredMidi but before renderNextBlock
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-    {
-        if (auto* voice = dynamic_cast<PluckVoice*>(synth.getVoice(i)))
-        {
-            // Check if this voice just started this note
-            if (!voice->isPlayingNote())  // Voice was free, will take this note
-            {
-                voiceAges[i] = ++voiceCounter;
-                break;  // Found the voice that will take it
-            }
-        }
-    }
+    // may come from the message thread, the synth does it before its next block
+    synth.requestStopAllVoices();
 }
 
-int PlucksAudioProcessor::getNumActiveVoices() const
+void PlucksAudioProcessor::setNoiseSeed(juce::uint32 newSeed)
 {
-    int count = 0;
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-    {
-        if (auto* voice = dynamic_cast<PluckVoice*>(synth.getVoice(i)))
-        {
-            if (voice->isVoiceActive())
-                ++count;
-        }
-    }
-    return count;
+    noiseSeed.store(newSeed);
+
+    // kept in the APVTS tree so it goes out (and comes back) with the rest of the state
+    parameters.state.setProperty("noiseSeed", static_cast<juce::int64>(newSeed), nullptr);
 }
 
-void PlucksAudioProcessor::stopAllVoicesGracefully()
+void PlucksAudioProcessor::setStringInterpolation(PluckStringDelay::Interpolation newInterpolation)
 {
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-    {
-        if (auto* voice = dynamic_cast<PluckVoice*>(synth.getVoice(i)))
-        {
-            voice->stopNote (0.0f, false);    // immediate stop
-            voice->clearCurrentNote();         // clear note state
-            voice->resetBuffers();             // reset any internal buffers/delays if applicable
-        }
-    }
+    // voices pick it up at their next note
+    stringInterpolation.store(newInterpolation);
+}
+
+void PlucksAudioProcessor::setSilenceFloorDb(float newFloorDb)
+{
+    // voices pick it up at their next note
+    silenceFloorDb.store(juce::jlimit(-140.0f, -20.0f, newFloorDb));
 }
 
+void PlucksAudioProcessor::setNoteTimerEnabled(bool shouldUseNoteTimer)
+{
+    noteTimer.store(shouldUseNoteTimer);
+}
+
+void PlucksAudioProcessor::setRenderThreads(int numThreads)
+{
+    renderThreads.store(juce::jlimit(0, PluckRenderPool::maxWorkers, numThreads));
+}
+
+void PlucksAudioProcessor::setRenderEngine(PluckSynth::Engine newEngine)
+{
+    // the engines keep separate string state, the synth stops every note when it switches
+    synth.setEngine(newEngine);
+}
 
 //==============================================================================
 bool PlucksAudioProcessor::hasEditor() const
 {
+   #if PLUCKS_HEADLESS
+    return false; // command line tools link the processor without the editor
+   #else
     return true; // (change this to false if you choose to not supply an editor)
+   #endif
 }
 
 juce::AudioProcessorEditor* PlucksAudioProcessor::createEditor()
 {
+   #if PLUCKS_HEADLESS
+    return nullptr;
+   #else
     return new PlucksAudioProcessorEditor (*this);
+   #endif
 }
 
 //==============================================================================
 void PlucksAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // Create XML from the current parameters state
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    // Copy the XML data to the destination memory block for host to save
-    copyXmlToBinary (*xml, destData);
+    PluckState state;
+
+    for (auto* p : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(p))
+            state.parameters.emplace_back(ranged->getParameterID(), ranged->convertFrom0to1(ranged->getValue()));
+
+    state.noiseSeed = noiseSeed.load();
+    state.stringInterpolation = static_cast<int>(stringInterpolation.load());
+    state.silenceFloorDb = silenceFloorDb.load();
+    state.noteTimer = noteTimer.load();
+    state.mpeEnabled = mpeEnabled.load();
+    state.pitchBendRange = pitchBendRange.load();
+    state.program = getCurrentProgram();
+    state.tuning = tuningSystem.getCurrentTable();
+
+    state.write(destData);
 }
 
 void PlucksAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // Restore the XML from binary data from the host
+    const juce::ScopedValueSetter<bool> following(followingProgram, true);
+    PluckState state;
+
+    if (state.read(data, sizeInBytes))
+    {
+        for (const auto& saved : state.parameters)
+            if (auto* parameter = parameters.getParameter(saved.first))
+                parameter->setValueNotifyingHost(parameter->convertTo0to1(saved.second));
+
+        setNoiseSeed(state.noiseSeed);
+        setStringInterpolation(static_cast<PluckStringDelay::Interpolation>(juce::jlimit(0, 2, state.stringInterpolation)));
+        setSilenceFloorDb(state.silenceFloorDb);
+        setNoteTimerEnabled(state.noteTimer);
+        setMpeEnabled(state.mpeEnabled);
+        setPitchBendRange(state.pitchBendRange);
+
+        // the saved parameters already are the program, so it isn't applied again
+        requestedProgram.store(-1);
+        currentProgram.store(presetBank.contains(state.program) ? state.program : 0);
+
+        tuningSystem.setTable(state.tuning);
+        return;
+    }
+
+    // Restore the XML from binary data from the host (states saved before the binary format)
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
 
     if (xmlState != nullptr)
@@ -458,6 +562,20 @@ void PlucksAudioProcessor::setStateInformation (const void* data, int sizeInByte
         {
             // Replace your parameters state with restored data
             parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+
+            // older states have no seed, which means random
+            noiseSeed.store(static_cast<juce::uint32>(static_cast<juce::int64>(parameters.state.getProperty("noiseSeed", 0))));
+
+            // nor a tuning table: the selection is all there is, a custom file stays as it is
+            if (auto* tuningType = dynamic_cast<juce::AudioParameterChoice*>(parameters.getParameter("TUNING_TYPE")))
+            {
+                if (tuningType->getIndex() <= (int) TuningSystem::Preset::meantone)
+                {
+                    TuningSystem::Table table;
+                    TuningSystem::makePreset(static_cast<TuningSystem::Preset>(tuningType->getIndex()), table);
+                    tuningSystem.setTable(table);
+                }
+            }
         }
     }
 }
@@ -1,10 +1,21 @@
 #pragma once
 #include <JuceHeader.h>
 #include "TuningSystem.h"
+#include "PluckParameters.h"
+#include "PluckExciterBank.h"
+#include "PluckCoefficientTable.h"
+#include "PluckStringDelay.h"
+#include "PluckSynth.h"
+#include "PluckTelemetry.h"
+#include "PluckVoiceBudget.h"
+#include "PluckMidiQueue.h"
+#include "PluckPresetBank.h"
+#include "PluckState.h"
 
 //==============================================================================
 
-class PlucksAudioProcessor  : public juce::AudioProcessor
+class PlucksAudioProcessor  : public juce::AudioProcessor,
+                              private juce::Timer
 {
 public:
     //==============================================================================
@@ -15,6 +26,7 @@ public:
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
 
     void releaseResources() override;
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
    #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
@@ -35,6 +47,8 @@ public:
     double getTailLengthSeconds() const override;
 
     //==============================================================================
+    // Programs come from PluckPresetBank. A change (from the host or a MIDI program change)
+    // lands at the top of the next block, straight away while the audio isn't running.
     int getNumPrograms() override;
     int getCurrentProgram() override;
     void setCurrentProgram (int index) override;
@@ -48,7 +62,7 @@ public:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
     juce::AudioProcessorValueTreeState parameters;
-    juce::Synthesiser synth;
+    PluckSynth synth;
 
     //========================= VOICE MANAGEMENT ===================================
     void setMaxVoicesAllowed(int newMax);
@@ -58,22 +72,108 @@ public:
     TuningSystem* getTuningSystem() noexcept { return &tuningSystem; }
     void stopAllVoicesGracefully();
 
+    // True while a program or a loaded state is being written into the parameters: the
+    // editor's attachments follow it, and its tuning came along already. Message thread.
+    bool isFollowingProgram() const noexcept { return followingProgram; }
+
+    // VoiceBank is the default, Reference keeps the original per-voice loop for A/B checks
+    void setRenderEngine(PluckSynth::Engine newEngine);
+    PluckSynth::Engine getRenderEngine() const { return synth.getEngine(); }
+
+    // Exciter noise seed, saved with the state. 0 = a fresh random seed per session,
+    // anything else makes renders repeat bit for bit. Message thread only (it writes the state tree).
+    void setNoiseSeed(juce::uint32 newSeed);
+    juce::uint32 getNoiseSeed() const noexcept { return noiseSeed.load(); }
+
+    // Fractional read of the string delays. Lagrange3rd is the original sound,
+    // Thiran rings brighter, Linear is the cheapest and darkest.
+    void setStringInterpolation(PluckStringDelay::Interpolation newInterpolation);
+    PluckStringDelay::Interpolation getStringInterpolation() const noexcept { return stringInterpolation.load(); }
+
+    // Voices end (with a short fade) once a whole period stays below this level.
+    // The old note timer is kept for A/B checks, it turns the silence check off.
+    void setSilenceFloorDb(float newFloorDb);
+    float getSilenceFloorDb() const noexcept { return silenceFloorDb.load(); }
+    void setNoteTimerEnabled(bool shouldUseNoteTimer);
+    bool isNoteTimerEnabled() const noexcept { return noteTimer.load(); }
+
+    // MPE lower zone (channel 1 master, 2..16 one note each) instead of one bend per channel,
+    // and the wheel's range in semitones without MPE. Any thread, picked up at the next block.
+    void setMpeEnabled(bool shouldUseMpe) { mpeEnabled.store(shouldUseMpe); }
+    bool isMpeEnabled() const noexcept { return mpeEnabled.load(); }
+    void setPitchBendRange(float semitones) { pitchBendRange.store(juce::jlimit(0.0f, 48.0f, semitones)); }
+    float getPitchBendRange() const noexcept { return pitchBendRange.load(); }
+
+    // Extra threads that render voices next to the audio thread, taken up at the next
+    // prepareToPlay. 0 (the default) renders on the audio thread only, which is what a
+    // host that already spreads tracks over its cores wants.
+    void setRenderThreads(int numThreads);
+    int getRenderThreads() const noexcept { return renderThreads.load(); }
+
+    // Block load, voice counts and note-on / render cost, see PluckTelemetry. Any thread.
+    PluckTelemetry::Snapshot getTelemetry() const { return telemetry.getSnapshot(); }
+    void resetTelemetry() { telemetry.requestReset(); }
+
+    // For the editor's share of the startup times. Message thread.
+    void startupStepTook(PluckTelemetry::StartupStep step, juce::int64 startTicks) { telemetry.startupStepTook(step, startTicks); }
+
+    // notes outside this range are dropped before they reach the synth,
+    // the voice arena is sized for lowestNote
+    static constexpr int lowestNote = 12;
+    static constexpr int highestNote = 108;
+
+    // what the voices are reading this block
+    const PluckParameters& getBlockParameters() const noexcept { return blockParameters; }
+
 private:
+    // cached raw parameter pointers + the snapshot taken at the top of each block
+    PluckParameterCache parameterCache;
+    PluckParameters blockParameters;
+
+    // precomputed exciters shared by all voices, built off the audio thread
+    PluckExciterBank exciterBank;
+
+    // loop coefficients per note, rebuilt at the top of a block when their parameters move
+    PluckCoefficientTable coefficientTable;
+
+    PluckTelemetry telemetry;
+
+    // ADAPTIVEVOICES: how many voices the last blocks' load leaves room for
+    PluckVoiceBudget voiceBudget;
+
+    // the block's MIDI after the note range filter, what the synth plays from
+    PluckMidiQueue midiQueue;
+
+    // programs with their tunings, ready to switch to from processBlock
+    PluckPresetBank presetBank;
+    std::atomic<int> requestedProgram { -1 };   // setCurrentProgram(), for the next block
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<bool> prepared { false };       // between prepareToPlay and releaseResources
+    bool followingProgram = false;              // see isFollowingProgram()
+
+    std::atomic<int> programToNotify { -1 };    // applied, the host hasn't heard yet
+    static constexpr int programNotifyHz = 30;
+
+    // parameters and tuning, true if the tuning changed. The host is told from the message
+    // thread: the timer picks programToNotify up, the audio thread only stores it.
+    bool applyProgram(int index);
+    void notifyProgramChange();
+    void timerCallback() override { notifyProgramChange(); }
+
+    std::atomic<juce::uint32> noiseSeed { 0 };
+    std::atomic<PluckStringDelay::Interpolation> stringInterpolation { PluckStringDelay::Interpolation::Lagrange3rd };
+    std::atomic<float> silenceFloorDb { -80.0f };
+    std::atomic<bool> noteTimer { false };
+    std::atomic<bool> mpeEnabled { false };
+    std::atomic<float> pitchBendRange { 2.0f };
+    std::atomic<int> renderThreads { 0 };
+    const juce::uint32 sessionSeed = static_cast<juce::uint32>(juce::Random().nextInt()) | 1u;
+    juce::uint32 getEffectiveNoiseSeed() const noexcept { const auto s = noiseSeed.load(); return s != 0 ? s : sessionSeed; }
 
     int maxVoicesAllowed = 16; // Default max polyphony
-    
-    float currentPitchBend = 0.0f; // TODO
 
     double currentSampleRate = 44100.0; // default fallback
 
-    // Minimal voice stealing - only when max poly reached
-    std::vector<uint64_t> voiceAges;
-    uint64_t voiceCounter;
-    
-    // Simple helper methods
-    int findOldestVoice();
-    void updateVoiceAgeForNewNote(int midiNote);
-
     TuningSystem tuningSystem;
 
     //==============================================================================
@@ -2,49 +2,382 @@
 #pragma once
 #include <JuceHeader.h>
 #include <array>
+#include <functional>
 #include <string>
+#include <vector>
 
+// A tuning is a full 128-note table of cent offsets from 12-TET. The presets and
+// .tun files fill it from 12 pitch classes, Scala .scl (+ .kbm) files note by note,
+// so scales with any number of steps and non-octave periods work.
+//
+// Per-note string periods (samples per cycle at 0 cents fine tune) are worked out
+// here off the audio thread, for the rate passed to prepare(); voices multiply them
+// by PluckParameters' delay scales instead of doing the pitch math per note. The
+// audio thread only ever looks them up, so every table that can go live has to be
+// at that rate: prepare() redoes ours, PluckPresetBank::prepare() its own.
+//
+// Changes never touch the table the audio thread reads. Presets and files are parsed
+// and worked out on a loader thread into a spare table (there are three: the live
+// one, one published and not picked up yet, one being built), which is published
+// through an atomic pointer. The audio thread switches over in beginBlock(), so a new
+// tuning lands on a block boundary and nothing reads a half written table.
+// selectTable() lets it switch to a table kept elsewhere (PluckPresetBank) directly.
 class TuningSystem
 {
 public:
+    static constexpr int numNotes = 128;
+
+    // One complete tuning, everything a voice reads plus its name for the UI
+    struct Table
+    {
+        std::array<float, numNotes> centDeviations {};
+        std::array<bool, numNotes> noteMapped {};
+        std::array<float, numNotes> periods {};
+        double sampleRate = 0.0;                // the rate the periods are for
+        juce::uint32 version = 0;
+        juce::String name;
+        int preset = -1;                        // Preset it was made from, -1 for a file
+
+        // the same 12 offsets in every octave, every key mapped
+        void setPitchClasses(const std::array<float, 12>& deviations, const juce::String& newName);
+
+        float computePeriod(int midiNote, double rate) const
+        {
+            const double freq = juce::MidiMessage::getMidiNoteInHertz(midiNote)
+                              * std::pow(2.0, (double) centDeviations[(size_t) midiNote] / 1200.0);
+
+            // a couple of samples is as short as the string's interpolators can go
+            return (float) juce::jmax(2.0, rate / freq);
+        }
+
+        void updatePeriods(double rate)
+        {
+            sampleRate = rate;
+
+            for (int note = 0; note < numNotes; ++note)
+                periods[(size_t) note] = computePeriod(note, rate > 0.0 ? rate : 44100.0);
+        }
+    };
+
+    enum class Preset
+    {
+        equalTemperament,
+        wellTemperament,
+        justIntonation,
+        pythagorean,
+        meantone
+    };
+
+    // Called on the message thread once the change is live (or has failed)
+    using Callback = std::function<void(bool succeeded)>;
+
     TuningSystem() 
     {
         // Initialize with equal temperament (all zeros = no deviation)
-        resetToEqualTemperament();
+        makePreset(Preset::equalTemperament, tables[0]);
+        newestTable = tables[0];
     }
-    
-    // Load .tun file (Scala format or simple cent deviations)
-    bool loadTuningFile(const juce::File& file);
-    
-    // Get cent deviation for a MIDI note (0-127)
-    float getCentDeviationForNote(int midiNote) const;
-    
+
+    ~TuningSystem()
+    {
+        loader.stopThread(2000);
+    }
+
+    //==============================================================================
+    // Message thread. Parsed and built on the loader thread, the audio thread picks the
+    // result up at its next block.
+
+    // Load .tun file (12 cent deviations), or a Scala .scl with the .kbm of the same
+    // name next to it when there is one
+    void loadTuningFile(const juce::File& file, Callback onDone = {});
+
+    void setPreset(Preset preset, Callback onDone = {});
+
+    // A complete table (a saved state), published right away on the calling thread
+    void setTable(const Table& table);
+
     // Preset tunings
-    void setWellTemperament();
-    void setJustIntonation();
-    void setPythagorean();
-    void setMeantone();
-    void resetToEqualTemperament();
-    
-    // Get tuning name for UI
-    const juce::String& getCurrentTuningName() const { return currentTuningName; }
-    
+    void setWellTemperament()       { setPreset(Preset::wellTemperament); }
+    void setJustIntonation()        { setPreset(Preset::justIntonation); }
+    void setPythagorean()           { setPreset(Preset::pythagorean); }
+    void setMeantone()              { setPreset(Preset::meantone); }
+    void resetToEqualTemperament()  { setPreset(Preset::equalTemperament); }
+
+    // The newest tuning that made it: one waiting for the next block, or else the one
+    // playing. For the UI and the saved state.
+    Table getCurrentTable() const
+    {
+        const juce::ScopedLock sl(publishLock);
+        const Table* current = liveTable.load();
+
+        // the preset bank's tables never change, ours may be rebuilt once they're not live
+        if (pendingTable.load() != nullptr || isOwned(current))
+            return newestTable;
+
+        return *current;
+    }
+
+    juce::String getCurrentTuningName() const { return getCurrentTable().name; }
+
+    // The Preset it was made from, -1 for a file
+    int getCurrentPreset() const { return getCurrentTable().preset; }
+
     // Check if custom tuning is loaded
-    bool hasCustomTuning() const { return !currentTuningName.isEmpty(); }
+    bool hasCustomTuning() const { return getCurrentTuningName().isNotEmpty(); }
+
+    //==============================================================================
+    // The parsers, any thread. They only fill 'table' (without periods) and return true on success.
+
+    static bool parseTuningFile(const juce::File& file, Table& table);
+
+    // Scala scale + optional keyboard mapping. Without a mapping, 1/1 sits on middle C
+    // at its 12-TET pitch and the scale runs linearly up and down the keyboard.
+    static bool parseScalaFile(const juce::File& sclFile, const juce::File& kbmFile, Table& table);
+
+    static void makePreset(Preset preset, Table& table);
+
+    // Gives a table built elsewhere (PluckPresetBank) a version of its own, so caches
+    // built from the live table see the switch. Not the audio thread.
+    void stamp(Table& table)
+    {
+        const juce::ScopedLock sl(publishLock);
+        table.version = ++lastVersion;
+    }
+
+    //==============================================================================
+    // Audio thread, top of the block: switches to a newly published tuning.
+    // True if it did, playing notes can then glide over to it.
+    bool beginBlock() noexcept
+    {
+        Table* next = pendingTable.load();
+        if (next == nullptr)
+            return false;
+
+        // live first: the loader reads pending, then live, and never builds into either
+        liveTable.store(next);
+        Table* expected = next;
+        pendingTable.compare_exchange_strong(expected, nullptr);
+        return true;
+    }
+
+    // Audio thread, top of the block (or whoever stands in for it while the audio is
+    // stopped): plays 'table' from now on. It has to stay put and have its periods worked
+    // out (stamp() and updatePeriods(), before the audio starts). A change the loader
+    // published and this block hasn't picked up is older, it's dropped.
+    // True if the table wasn't the live one already.
+    bool selectTable(const Table& table) noexcept
+    {
+        Table* dropped = pendingTable.load();
+        if (dropped != nullptr)
+            pendingTable.compare_exchange_strong(dropped, nullptr);
+
+        return liveTable.exchange(&table) != &table;
+    }
+
+    // Works the period tables out for this rate: the live one, one published and not
+    // picked up yet, the spare, and everything published from now on. Not realtime
+    // safe, and not while the audio thread runs (prepareToPlay).
+    void prepare(double sampleRate)
+    {
+        const juce::ScopedLock sl(publishLock);
+        preparedSampleRate.store(sampleRate);
+
+        // a preset bank table does its own
+        for (auto& table : tables)
+            table.updatePeriods(sampleRate);
+
+        newestTable.updatePeriods(sampleRate);
+    }
+
+    // The rest reads the live table: the audio thread, or a render pool worker mid-block.
+
+    // Get cent deviation for a MIDI note (0-127)
+    float getCentDeviationForNote(int midiNote) const
+    {
+        return juce::isPositiveAndBelow(midiNote, numNotes) ? live().centDeviations[(size_t) midiNote] : 0.0f;
+    }
+
+    // Keys a .kbm leaves unmapped ('x') keep their 12-TET pitch
+    bool isNoteMapped(int midiNote) const { return juce::isPositiveAndBelow(midiNote, numNotes) && live().noteMapped[(size_t) midiNote]; }
+
+    // Samples per cycle of the string for this note, before fine tune. A table lookup,
+    // only valid at the prepared rate.
+    float getPeriodInSamples(int midiNote, double sampleRate) const
+    {
+        midiNote = juce::jlimit(0, numNotes - 1, midiNote);
+        const auto& t = live();
+
+        // a table that went live without being prepared for this rate (see prepare())
+        jassert(sampleRate == t.sampleRate);
+        juce::ignoreUnused(sampleRate);
+
+        return t.periods[(size_t) midiNote];
+    }
+
+    // Every note's period at this rate, for PluckExciterBank's builder thread
+    void getPeriods(double sampleRate, std::array<float, numNotes>& periods) const
+    {
+        for (int note = 0; note < numNotes; ++note)
+            periods[(size_t) note] = getPeriodInSamples(note, sampleRate);
+    }
+
+    // Bumped on every change, so caches built from the deviations know when to rebuild
+    juce::uint32 getVersion() const { return live().version; }
 
 private:
-    // Store cent deviations for each of the 12 pitch classes
-    std::array<float, 12> centDeviations;
-    juce::String currentTuningName;
-    
-    void setCentDeviations(const std::array<float, 12>& deviations, const juce::String& name);
+    const Table& live() const noexcept { return *liveTable.load(std::memory_order_relaxed); }
+
+    bool isOwned(const Table* table) const noexcept
+    {
+        return table >= tables.data() && table < tables.data() + tables.size();
+    }
+
+    // one change to make: fills a table, false if it can't (a bad file)
+    struct Job
+    {
+        std::function<bool(Table&)> build;
+        Callback onDone;
+    };
+
+    class Loader : public juce::Thread
+    {
+    public:
+        explicit Loader(TuningSystem& t) : juce::Thread("Plucks tuning loader"), tuning(t) {}
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                tuning.runJobs();
+                wait(-1);
+            }
+        }
+
+    private:
+        TuningSystem& tuning;
+    };
+
+    // A newer request replaces one that hasn't started yet: only the last
+    // selection matters, and its callback is the only one that runs.
+    void addJob(Job job)
+    {
+        {
+            const juce::ScopedLock sl(jobLock);
+            nextJob = std::move(job);
+        }
+
+        if (! loader.isThreadRunning())
+            loader.startThread(juce::Thread::Priority::low);
+
+        loader.notify();
+    }
+
+    // Loader thread.
+    void runJobs()
+    {
+        for (;;)
+        {
+            Job job;
+            {
+                const juce::ScopedLock sl(jobLock);
+                if (! nextJob.build)
+                    return;
+
+                job = std::move(nextJob);
+                nextJob = {};
+            }
+
+            const bool succeeded = buildAndPublish(job.build);
+
+            if (job.onDone)
+                juce::MessageManager::callAsync([onDone = std::move(job.onDone), succeeded] { onDone(succeeded); });
+        }
+    }
+
+    bool buildAndPublish(const std::function<bool(Table&)>& build)
+    {
+        Table built;
+
+        if (! build(built))
+            return false;
+
+        publish(built);
+        return true;
+    }
+
+    // The loader thread, or setTable(): one at a time under publishLock
+    void publish(const Table& built)
+    {
+        const juce::ScopedLock sl(publishLock);
+
+        // pending before live, see beginBlock(): whatever the audio thread does in
+        // between, the table picked here is one it can't be reading
+        const Table* pending = pendingTable.load();
+        const Table* current = liveTable.load();
+
+        size_t spare = 0;
+        while (&tables[spare] == pending || &tables[spare] == current)
+            ++spare;
+
+        auto& table = tables[spare];
+        table = built;
+        table.updatePeriods(preparedSampleRate.load());
+        table.version = ++lastVersion;
+        newestTable = table;
+
+        // anything still pending was never picked up, it just becomes the next spare
+        pendingTable.exchange(&table);
+    }
+
+    // one pitch line of a .scl, in cents: "701.955", "3/2" or "2"
+    static bool parseScalaPitch(const juce::String& line, double& cents);
+
+    static void makeWellTemperament(Table& table);
+    static void makeJustIntonation(Table& table);
+    static void makePythagorean(Table& table);
+    static void makeMeantone(Table& table);
+
+    std::array<Table, 3> tables;
+    std::atomic<const Table*> liveTable { &tables[0] };     // what the audio thread reads
+    std::atomic<Table*> pendingTable { nullptr };           // published, not picked up yet
+    std::atomic<double> preparedSampleRate { 0.0 };
+
+    juce::CriticalSection jobLock;              // message thread <-> loader, never the audio thread
+    Job nextJob;
+
+    juce::CriticalSection publishLock;          // never the audio thread
+    Table newestTable;                          // a copy of the last one published
+    juce::uint32 lastVersion = 0;
+
+    Loader loader { *this };
 };
 
 // TuningSystem.cpp implementation
-inline bool TuningSystem::loadTuningFile(const juce::File& file)
+inline void TuningSystem::loadTuningFile(const juce::File& file, Callback onDone)
+{
+    addJob({ [file](Table& table) { return parseTuningFile(file, table); }, std::move(onDone) });
+}
+
+inline void TuningSystem::setPreset(Preset preset, Callback onDone)
+{
+    addJob({ [preset](Table& table) { makePreset(preset, table); return true; }, std::move(onDone) });
+}
+
+inline void TuningSystem::setTable(const Table& table)
+{
+    publish(table);
+}
+
+inline bool TuningSystem::parseTuningFile(const juce::File& file, Table& table)
 {
     if (!file.exists())
         return false;
+
+    if (file.hasFileExtension("scl"))
+    {
+        const auto kbm = file.withFileExtension("kbm");
+        return parseScalaFile(file, kbm.existsAsFile() ? kbm : juce::File(), table);
+    }
         
     auto content = file.loadFileAsString();
     auto lines = juce::StringArray::fromLines(content);
@@ -72,26 +405,173 @@ inline bool TuningSystem::loadTuningFile(const juce::File& file)
     
     if (noteIndex >= 12)
     {
-        setCentDeviations(newDeviations, file.getFileNameWithoutExtension());
+        table.setPitchClasses(newDeviations, file.getFileNameWithoutExtension());
         return true;
     }
     
     return false;
 }
 
-inline float TuningSystem::getCentDeviationForNote(int midiNote) const
+inline bool TuningSystem::parseScalaPitch(const juce::String& line, double& cents)
 {
-    if (midiNote < 0 || midiNote > 127)
-        return 0.0f;
-        
-    int pitchClass = midiNote % 12;
-    return centDeviations[pitchClass];
+    // anything after the value is a comment
+    const auto value = line.trim().upToFirstOccurrenceOf(" ", false, false).upToFirstOccurrenceOf("\t", false, false);
+
+    if (value.isEmpty())
+        return false;
+
+    if (value.containsChar('.'))
+    {
+        cents = value.getDoubleValue();
+        return true;
+    }
+
+    const double numerator = value.upToFirstOccurrenceOf("/", false, false).getDoubleValue();
+    const double denominator = value.containsChar('/') ? value.fromFirstOccurrenceOf("/", false, false).getDoubleValue() : 1.0;
+
+    if (numerator <= 0.0 || denominator <= 0.0)
+        return false;
+
+    cents = 1200.0 * std::log2(numerator / denominator);
+    return true;
 }
 
-inline void TuningSystem::setWellTemperament()
+inline bool TuningSystem::parseScalaFile(const juce::File& sclFile, const juce::File& kbmFile, Table& table)
+{
+    if (! sclFile.existsAsFile())
+        return false;
+
+    // .scl: description, number of notes, then one pitch per note; the last one is the period
+    juce::StringArray sclLines;
+    for (const auto& line : juce::StringArray::fromLines(sclFile.loadFileAsString()))
+        if (! line.trimStart().startsWith("!"))
+            sclLines.add(line);
+
+    if (sclLines.size() < 2)
+        return false;
+
+    const int numDegrees = sclLines[1].trim().getIntValue();
+    if (numDegrees < 1 || sclLines.size() < 2 + numDegrees)
+        return false;
+
+    std::vector<double> degreeCents { 0.0 };   // 1/1 is implied
+    for (int i = 0; i < numDegrees; ++i)
+    {
+        double cents = 0.0;
+        if (! parseScalaPitch(sclLines[2 + i], cents))
+            return false;
+
+        degreeCents.push_back(cents);
+    }
+
+    // .kbm: map size, first / last note, middle note, reference note and frequency,
+    // formal octave degree, then one scale degree (or x) per key of the map
+    int mapSize = 0, firstNote = 0, lastNote = numNotes - 1, middleNote = 60, referenceNote = 60, octaveDegree = numDegrees;
+    double referenceFreq = juce::MidiMessage::getMidiNoteInHertz(60);
+    std::vector<int> keyMap;                    // -1 for unmapped keys
+
+    if (kbmFile != juce::File())
+    {
+        juce::StringArray values;
+        for (const auto& line : juce::StringArray::fromLines(kbmFile.loadFileAsString()))
+            if (line.trim().isNotEmpty() && ! line.trimStart().startsWith("!"))
+                values.add(line.trim().upToFirstOccurrenceOf(" ", false, false));
+
+        if (values.size() < 7)
+            return false;
+
+        mapSize = values[0].getIntValue();
+        firstNote = values[1].getIntValue();
+        lastNote = values[2].getIntValue();
+        middleNote = values[3].getIntValue();
+        referenceNote = values[4].getIntValue();
+        referenceFreq = values[5].getDoubleValue();
+        octaveDegree = values[6].getIntValue();
+
+        if (mapSize < 0 || referenceFreq <= 0.0 || ! juce::isPositiveAndNotGreaterThan(octaveDegree, numDegrees))
+            return false;
+
+        for (int i = 0; i < mapSize; ++i)
+        {
+            // missing trailing entries count as unmapped
+            const auto entry = i + 7 < values.size() ? values[i + 7] : juce::String("x");
+            keyMap.push_back(entry.startsWithIgnoreCase("x") ? -1 : entry.getIntValue());
+        }
+    }
+
+    // degree d (any integer) in cents above 1/1, a whole period per numDegrees steps
+    const double period = degreeCents[(size_t) numDegrees];
+    auto getDegreeCents = [&](int degree)
+    {
+        const int numPeriods = (int) std::floor((double) degree / numDegrees);
+        return numPeriods * period + degreeCents[(size_t) (degree - numPeriods * numDegrees)];
+    };
+
+    // cents above 1/1 for a key, false when the map leaves it out
+    const double formalOctave = mapSize > 0 ? getDegreeCents(octaveDegree) : period;
+    auto getKeyCents = [&](int note, double& cents)
+    {
+        const int steps = note - middleNote;
+
+        if (mapSize == 0)
+        {
+            cents = getDegreeCents(steps);
+            return true;
+        }
+
+        const int octaves = (int) std::floor((double) steps / mapSize);
+        const int degree = keyMap[(size_t) (steps - octaves * mapSize)];
+
+        if (degree < 0)
+            return false;
+
+        cents = octaves * formalOctave + getDegreeCents(degree);
+        return true;
+    };
+
+    double referenceCents = 0.0;
+    if (! getKeyCents(referenceNote, referenceCents))
+        return false;
+
+    std::array<float, numNotes> deviations {};
+    std::array<bool, numNotes> mapped {};
+
+    for (int note = 0; note < numNotes; ++note)
+    {
+        double cents = 0.0;
+        if (note < firstNote || note > lastNote || ! getKeyCents(note, cents))
+            continue;
+
+        const double freq = referenceFreq * std::pow(2.0, (cents - referenceCents) / 1200.0);
+        deviations[(size_t) note] = (float) (1200.0 * std::log2(freq / juce::MidiMessage::getMidiNoteInHertz(note)));
+        mapped[(size_t) note] = true;
+    }
+
+    table.centDeviations = deviations;
+    table.noteMapped = mapped;
+    table.name = sclFile.getFileNameWithoutExtension();
+    return true;
+}
+
+inline void TuningSystem::makePreset(Preset preset, Table& table)
+{
+    switch (preset)
+    {
+        case Preset::wellTemperament:       makeWellTemperament(table); break;
+        case Preset::justIntonation:        makeJustIntonation(table); break;
+        case Preset::pythagorean:           makePythagorean(table); break;
+        case Preset::meantone:              makeMeantone(table); break;
+        case Preset::equalTemperament:
+        default:                            table.setPitchClasses({}, "Equal Temperament"); break;
+    }
+
+    table.preset = (int) preset;
+}
+
+inline void TuningSystem::makeWellTemperament(Table& table)
 {
     // Bach/Kirnberger III well temperament (approximate)
-    setCentDeviations({
+    table.setPitchClasses({
         0.0f,    // C
         -5.9f,   // C#
         -7.8f,   // D
@@ -107,10 +587,10 @@ inline void TuningSystem::setWellTemperament()
     }, "Well Temperament");
 }
 
-inline void TuningSystem::setJustIntonation()
+inline void TuningSystem::makeJustIntonation(Table& table)
 {
     // Just intonation in C major
-    setCentDeviations({
+    table.setPitchClasses({
         0.0f,     // C (1/1)
         70.7f,    // C# (16/15)
         3.9f,     // D (9/8)
@@ -126,10 +606,10 @@ inline void TuningSystem::setJustIntonation()
     }, "Just Intonation");
 }
 
-inline void TuningSystem::setPythagorean()
+inline void TuningSystem::makePythagorean(Table& table)
 {
     // Pythagorean tuning
-    setCentDeviations({
+    table.setPitchClasses({
         0.0f,     // C
         13.7f,    // C#
         3.9f,     // D
@@ -145,10 +625,10 @@ inline void TuningSystem::setPythagorean()
     }, "Pythagorean");
 }
 
-inline void TuningSystem::setMeantone()
+inline void TuningSystem::makeMeantone(Table& table)
 {
     // Quarter-comma meantone
-    setCentDeviations({
+    table.setPitchClasses({
         0.0f,     // C
         -24.3f,   // C#
         -6.8f,    // D
@@ -164,14 +644,11 @@ inline void TuningSystem::setMeantone()
     }, "Meantone");
 }
 
-inline void TuningSystem::resetToEqualTemperament()
+inline void TuningSystem::Table::setPitchClasses(const std::array<float, 12>& deviations, const juce::String& newName)
 {
-    centDeviations.fill(0.0f);
-    currentTuningName = "Equal Temperament";
-}
+    for (int note = 0; note < numNotes; ++note)
+        centDeviations[(size_t) note] = deviations[(size_t) (note % 12)];
 
-inline void TuningSystem::setCentDeviations(const std::array<float, 12>& deviations, const juce::String& name)
-{
-    centDeviations = deviations;
-    currentTuningName = name;
-}
\ No newline at end of file
+    noteMapped.fill(true);
+    name = newName;
+}
@@ -0,0 +1,590 @@
+/*
+  ==============================================================================
+
+    CheckMain.cpp
+
+    PlucksCheck: the equivalence checks behind the DSP optimisations, so
+    their "same output" claims can be re-run on any build.
+
+      spans         the reference string loop and the voice bank give the
+                    same samples whatever the block size: blocks of 1-47
+                    samples against 64-sample blocks, through a mid-block
+                    re-excite, gate and note timer fades and a DAMP ramp
+      mono          with STEREO off both outputs are the same string, bit
+                    for bit, also once STEREO is switched on under a ringing
+                    note and it is re-excited
+      midi_queue    raw MIDI bytes decoded into a PluckMidiQueue play the
+                    same as calling the synth directly, for every message
+                    type it keeps; a controller burst can't push note-offs
+                    out of a full queue
+      kernels       the reference engine's specialised string kernels and the
+                    voice bank agree for every interpolation, mono and
+                    stereo, with the loop coefficients steady or ramping
+                    (to kernelTolerance, they round differently) and with
+                    the pitch bend gliding (to bendTolerance, as an error
+                    relative to the signal)
+
+    Every check runs a bare PluckSynth (no processor, exciter bank or
+    coefficient table) on a fixed noise seed, so the numbers only depend on
+    the string code. The note timer is on where voices have to end at the
+    same sample: the silence floor is measured per block by design.
+
+      PlucksCheck [--only=name] [--digests]
+
+    --digests prints a hash of the output of one fixed script per engine,
+    interpolation and STEREO setting instead. Build PlucksCheck on both
+    sides of a change and diff the lines to see whether it moved the
+    output by a single bit.
+
+    Exits with 1 if a check fails.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluckSynth.h"
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    using Engine = PluckSynth::Engine;
+
+    constexpr double sampleRate = 48000.0;
+    constexpr int numVoices = 8;
+    constexpr int lowestNote = 12;              // same as the processor's
+    constexpr int scriptBlockSize = 64;
+    constexpr int scriptBlocks = 3000;          // 4 s at 48 kHz
+    constexpr juce::uint32 noiseSeed = 99;
+    constexpr double kernelTolerance = 1.0e-3;  // reference against voice bank, largest sample difference
+    constexpr double bendTolerance = 2.0e-3;    // the same while bending, RMS of the difference over RMS of the output
+    constexpr double thiranBendTolerance = 5.0e-2;
+
+    const char* engineName(Engine e)
+    {
+        return e == Engine::Reference ? "reference" : "bank";
+    }
+
+    const char* interpolationName(int interpolation)
+    {
+        switch (static_cast<PluckStringDelay::Interpolation>(interpolation))
+        {
+            case PluckStringDelay::Interpolation::Linear:   return "linear";
+            case PluckStringDelay::Interpolation::Thiran:   return "thiran";
+            default:                                        return "lagrange";
+        }
+    }
+
+    //==============================================================================
+    // A synth set up the way the processor sets one up, with the parameters held here
+    struct TestSynth
+    {
+        TestSynth(Engine engine, const PluckParameters& initial)
+            : params(initial)
+        {
+            params.noiseSeed = noiseSeed;
+            params.updateDelayScales();
+
+            for (int i = 0; i < numVoices; ++i)
+                synth.addVoice(new PluckVoice(params))->setNoiseStream(i);
+
+            synth.prepareVoiceBank();
+            synth.setCurrentPlaybackSampleRate(sampleRate);
+            synth.prepareVoiceMemory(sampleRate, lowestNote);
+            synth.setEngine(engine);
+            synth.stopAllVoices();
+            synth.setVoiceLimit(numVoices);
+            synth.setGateEnabled(params.gateEnabled);
+        }
+
+        // Pushes what changed into the playing voices, like processBlock does
+        void changeParameters(const std::function<void(PluckParameters&)>& change)
+        {
+            const auto previous = params;
+            change(params);
+            params.updateDelayScales(previous);
+
+            const auto changed = params.getChangedFields(previous);
+            synth.forEachActiveVoice([&](PluckVoice& voice) { voice.applyParameters(params, changed); });
+        }
+
+        PluckParameters params;
+        PluckSynth synth;
+    };
+
+    //==============================================================================
+    struct Script
+    {
+        // a pitch wheel move and a fine tune change: those step on block boundaries,
+        // so they're left out where block sizes are compared
+        bool glides = false;
+
+        // STEREO goes on while the first notes ring
+        bool stereoSwitch = false;
+    };
+
+    // What the script does at the start of a 64-sample block
+    void playScript(TestSynth& t, const Script& script, int block, int samplePosition)
+    {
+        switch (block)
+        {
+            case 0:
+                for (int note : { 36, 48, 55, 60, 64, 67, 72, 84 })
+                    t.synth.noteOn(note, 0.3f + (float) note / 200.0f, samplePosition);
+                break;
+
+            case 200:   if (script.stereoSwitch) t.changeParameters([](PluckParameters& p) { p.stereoEnabled = true; }); break;
+            case 400:   t.synth.noteOn(60, 0.9f, samplePosition + 37); break;  // re-excite mid-block, or a gate retrigger
+            case 700:   if (script.glides) t.synth.pitchWheelMoved(1, 12000); break;
+            case 900:   if (script.glides) t.changeParameters([](PluckParameters& p) { p.fineTuneCents = 25.0f; }); break;
+            case 1100:  t.changeParameters([](PluckParameters& p) { p.damp = 0.6f; }); break;
+
+            case 1300:
+                for (int note : { 48, 64, 72 })
+                    t.synth.noteOff(note, 0.0f);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // Renders the script into one long buffer. nextBlockSize() picks each block's length,
+    // the blocks are cut again wherever the script has something to do.
+    juce::AudioBuffer<float> renderScript(TestSynth& t, const Script& script, const std::function<int()>& nextBlockSize)
+    {
+        const int total = scriptBlockSize * scriptBlocks;
+        juce::AudioBuffer<float> output(2, total);
+        output.clear();
+
+        const PluckMidiQueue noMidi;
+
+        for (int pos = 0; pos < total;)
+        {
+            const int nextScriptBlock = (pos / scriptBlockSize + 1) * scriptBlockSize;
+            const int numSamples = juce::jmin(nextBlockSize(), nextScriptBlock - pos, total - pos);
+
+            if (pos % scriptBlockSize == 0)
+                playScript(t, script, pos / scriptBlockSize, pos);
+
+            t.synth.renderNextBlock(output, noMidi, pos, numSamples);
+            pos += numSamples;
+        }
+
+        return output;
+    }
+
+    juce::AudioBuffer<float> renderScript(TestSynth& t, const Script& script)
+    {
+        return renderScript(t, script, [] { return scriptBlockSize; });
+    }
+
+    // Largest sample difference, -1 if the sizes don't match
+    double getMaxDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+            return -1.0;
+
+        double worst = 0.0;
+
+        for (int ch = 0; ch < a.getNumChannels(); ++ch)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                worst = juce::jmax(worst, (double) std::abs(a.getSample(ch, i) - b.getSample(ch, i)));
+
+        return worst;
+    }
+
+    // FNV-1a over the sample bits
+    juce::uint64 getDigest(const juce::AudioBuffer<float>& buffer)
+    {
+        juce::uint64 hash = 14695981039346656037ull;
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                juce::uint32 bits;
+                const float sample = buffer.getSample(ch, i);
+                std::memcpy(&bits, &sample, sizeof(bits));
+
+                for (int byte = 0; byte < 4; ++byte)
+                {
+                    hash ^= (bits >> (8 * byte)) & 0xff;
+                    hash *= 1099511628211ull;
+                }
+            }
+        }
+
+        return hash;
+    }
+
+    //==============================================================================
+    struct Checker
+    {
+        // Prints one case, counts it as a failure unless it passed
+        void report(const juce::String& check, const juce::String& what, bool passed, double difference,
+                    const char* measure = "max diff")
+        {
+            std::cout << (passed ? "ok    " : "FAIL  ") << check.paddedRight(' ', 12) << what
+                      << "  " << measure << " " << difference << std::endl;
+
+            if (! passed)
+                ++failures;
+        }
+
+        int failures = 0;
+    };
+
+    //==============================================================================
+    // The reference loop cuts each block into spans where its state changes (re-excite,
+    // end of the exciter, the note timer, the end of a fade), the voice bank cuts at
+    // re-excites. Random block lengths move every one of those cuts around.
+    void checkSpans(Checker& checker)
+    {
+        for (auto engine : { Engine::Reference, Engine::VoiceBank })
+        for (int interpolation = 0; interpolation < 3; ++interpolation)
+        for (bool stereo : { false, true })
+        for (bool gate : { false, true })
+        {
+            PluckParameters p;
+            p.stringInterpolation = interpolation;
+            p.stereoEnabled = stereo;
+            p.stereoMicrotuneCents = 2.0f;
+            p.gateEnabled = gate;
+            p.decay = 2.0f;
+            p.noteTimer = true;
+
+            TestSynth fixed(engine, p), random(engine, p);
+
+            std::mt19937 rng(5);
+            const auto a = renderScript(fixed, {});
+            const auto b = renderScript(random, {}, [&] { return 1 + (int) (rng() % 47); });
+
+            const double diff = getMaxDifference(a, b);
+
+            checker.report("spans", juce::String(engineName(engine)) + " " + interpolationName(interpolation)
+                                      + (stereo ? " stereo" : " mono") + (gate ? " gate" : ""),
+                           diff == 0.0, diff);
+        }
+    }
+
+    //==============================================================================
+    // A mono string is rendered once and added to both outputs. STEREO is latched at
+    // note start and kept through re-excites, so switching it on doesn't split a string
+    // that's already ringing.
+    void checkMono(Checker& checker)
+    {
+        for (auto engine : { Engine::Reference, Engine::VoiceBank })
+        for (int interpolation = 0; interpolation < 3; ++interpolation)
+        for (bool stereoSwitch : { false, true })
+        {
+            PluckParameters p;
+            p.stringInterpolation = interpolation;
+            p.stereoEnabled = false;
+            p.stereoMicrotuneCents = 2.0f;
+            p.decay = 2.0f;
+
+            Script script;
+            script.glides = true;
+            script.stereoSwitch = stereoSwitch;
+
+            TestSynth t(engine, p);
+            const auto output = renderScript(t, script);
+
+            double diff = 0.0;
+            for (int i = 0; i < output.getNumSamples(); ++i)
+                diff = juce::jmax(diff, (double) std::abs(output.getSample(0, i) - output.getSample(1, i)));
+
+            checker.report("mono", juce::String(engineName(engine)) + " " + interpolationName(interpolation)
+                                     + (stereoSwitch ? " STEREO switched on" : ""),
+                           diff == 0.0, diff);
+        }
+    }
+
+    //==============================================================================
+    // One MIDI message: its bytes for the queue, and what the synth should do with it
+    struct MidiStep
+    {
+        int samplePosition;
+        std::vector<juce::uint8> bytes;
+        std::function<void(PluckSynth&)> direct;
+    };
+
+    // The messages at the start of a 64-sample block. They sit at 0 or 32 only, so the
+    // synth splits the block the same way the direct side does.
+    std::vector<MidiStep> getMidiSteps(int block)
+    {
+        std::vector<MidiStep> steps;
+
+        const auto note = (juce::uint8) (40 + block / 50 % 30);
+        const auto value = (juce::uint8) (block % 128);
+
+        if (block % 50 == 0)
+            steps.push_back({ 0, { 0x90, note, 100 }, [=](PluckSynth& s) { s.noteOn(note, 100.0f / 127.0f, 0, 1); } });
+
+        if (block % 50 == 20)
+            steps.push_back({ 32, { 0x80, note, 64 }, [=](PluckSynth& s) { s.noteOff(note, 64.0f / 127.0f, 1); } });
+
+        if (block % 70 == 5)
+            steps.push_back({ 32, { 0xe0, 0x00, value }, [=](PluckSynth& s) { s.pitchWheelMoved(1, value << 7); } });
+
+        if (block % 90 == 7)
+            steps.push_back({ 0, { 0xd0, value }, [=](PluckSynth& s) { s.channelPressureChanged(1, value); } });
+
+        if (block % 110 == 9)
+            steps.push_back({ 32, { 0xa0, note, value }, [=](PluckSynth& s) { s.aftertouchChanged(1, note, value); } });
+
+        switch (block)
+        {
+            case 600:   steps.push_back({ 0, { 0xb0, 64, 127 }, [](PluckSynth& s) { s.handleSustainPedal(1, true); } }); break;
+            case 640:   steps.push_back({ 32, { 0x90, 50, 0 }, [](PluckSynth& s) { s.noteOff(50, 0.0f, 1); } }); break;  // note-on, velocity 0
+            case 700:   steps.push_back({ 0, { 0xb0, 64, 0 }, [](PluckSynth& s) { s.handleSustainPedal(1, false); } }); break;
+            case 900:   steps.push_back({ 32, { 0xb0, 121, 0 }, [](PluckSynth& s) { s.pitchWheelMoved(1, 8192); s.channelPressureChanged(1, 0); } }); break;
+            case 1190:  steps.push_back({ 0, { 0x91, 70, 90 }, [](PluckSynth& s) { s.noteOn(70, 90.0f / 127.0f, 0, 2); } }); break;
+            case 1200:  steps.push_back({ 0, { 0xb0, 120, 0 }, [](PluckSynth& s) { s.allNotesOff(1); } }); break;  // not channel 2's
+            case 1230:  steps.push_back({ 32, { 0xb1, 123, 0 }, [](PluckSynth& s) { s.allNotesOff(2); } }); break;
+            case 1500:  steps.push_back({ 32, { 0xb0, 123, 0 }, [](PluckSynth& s) { s.allNotesOff(1); } }); break;
+            default:    break;
+        }
+
+        // none of these reach the synth: another CC, a program change (the processor's), sysex
+        steps.push_back({ 10, { 0xb0, 7, 99 }, nullptr });
+        steps.push_back({ 20, { 0xc0, 3 }, nullptr });
+        steps.push_back({ 40, { 0xf0, 0x7e, 0xf7 }, nullptr });
+
+        std::stable_sort(steps.begin(), steps.end(), [](const MidiStep& a, const MidiStep& b) { return a.samplePosition < b.samplePosition; });
+        return steps;
+    }
+
+    void checkMidiQueue(Checker& checker)
+    {
+        for (auto engine : { Engine::Reference, Engine::VoiceBank })
+        {
+            PluckParameters p;
+            p.decay = 2.0f;
+
+            TestSynth queued(engine, p), direct(engine, p);
+
+            juce::AudioBuffer<float> a(2, scriptBlockSize), b(2, scriptBlockSize);
+            PluckMidiQueue queue;
+            const PluckMidiQueue noMidi;
+            double diff = 0.0;
+
+            for (int block = 0; block < scriptBlocks; ++block)
+            {
+                const auto steps = getMidiSteps(block);
+
+                queue.clear();
+
+                for (const auto& step : steps)
+                {
+                    const auto event = PluckMidiQueue::decode(step.bytes.data(), (int) step.bytes.size(), step.samplePosition);
+
+                    // processBlock takes these out
+                    if (event.type != PluckMidiQueue::Type::programChange)
+                        queue.add(event);
+                }
+
+                a.clear();
+                queued.synth.renderNextBlock(a, queue, 0, scriptBlockSize);
+
+                b.clear();
+                int rendered = 0;
+
+                for (const auto& step : steps)
+                {
+                    if (step.direct == nullptr)
+                        continue;
+
+                    if (step.samplePosition > rendered)
+                    {
+                        direct.synth.renderNextBlock(b, noMidi, rendered, step.samplePosition - rendered);
+                        rendered = step.samplePosition;
+                    }
+
+                    step.direct(direct.synth);
+                }
+
+                direct.synth.renderNextBlock(b, noMidi, rendered, scriptBlockSize - rendered);
+
+                diff = juce::jmax(diff, getMaxDifference(a, b));
+            }
+
+            checker.report("midi_queue", juce::String(engineName(engine)) + " queue against direct calls", diff == 0.0, diff);
+        }
+
+        // 20000 pitch wheel moves on two channels fill the queue, then as many note-offs
+        // as there are reserved slots have to fit
+        PluckMidiQueue queue(1024);
+
+        for (int i = 0; i < 20000; ++i)
+        {
+            const juce::uint8 wheel[] = { (juce::uint8) (0xe0 | (i % 2)), (juce::uint8) (i & 0x7f), 64 };
+            queue.add(PluckMidiQueue::decode(wheel, 3, i / 400));
+        }
+
+        const int afterBurst = queue.getNumEvents();
+        queue.takeNumDropped();
+
+        for (int i = 0; i < PluckMidiQueue::reservedSlots; ++i)
+        {
+            const juce::uint8 noteOff[] = { 0x80, (juce::uint8) (i % 128), 0 };
+            queue.add(PluckMidiQueue::decode(noteOff, 3, 60));
+        }
+
+        const auto droppedOffs = queue.takeNumDropped();
+        checker.report("midi_queue", "note-offs after a controller burst (" + juce::String(afterBurst) + " events queued, "
+                                         + juce::String((int) droppedOffs) + " note-offs dropped)",
+                       afterBurst <= queue.getCapacity() - PluckMidiQueue::reservedSlots && droppedOffs == 0, 0.0);
+    }
+
+    //==============================================================================
+    // The reference loop runs one kernel per interpolation, motion and string count, the
+    // voice bank has its own. Each motion is held for the whole render: DAMP moving every
+    // block keeps the coefficient ramps going, a pitch wheel move every block keeps the
+    // bend gliding.
+    //
+    // The engines step a bend differently (the reference a factor per sample, the bank a
+    // delay per sample, re-synced every controlBlockSize), so the delays drift apart by
+    // rounding. Bending is compared by the relative error instead. A Thiran read also
+    // switches taps where the fraction crosses 0.618; the engines can switch a sample
+    // apart and each switch leaves a short transient, hence its looser tolerance.
+    void checkKernels(Checker& checker)
+    {
+        const char* const motionNames[] = { "steady", "ramping", "bending" };
+
+        for (int interpolation = 0; interpolation < 3; ++interpolation)
+        for (bool stereo : { false, true })
+        for (int motion = 0; motion < 3; ++motion)
+        {
+            PluckParameters p;
+            p.stringInterpolation = interpolation;
+            p.stereoEnabled = stereo;
+            p.stereoMicrotuneCents = 2.0f;
+            p.decay = 3.0f;
+            p.noteTimer = true;
+
+            TestSynth reference(Engine::Reference, p), bank(Engine::VoiceBank, p);
+
+            juce::AudioBuffer<float> a(2, scriptBlockSize), b(2, scriptBlockSize);
+            const PluckMidiQueue noMidi;
+            double diff = 0.0, errorEnergy = 0.0, signalEnergy = 0.0;
+
+            for (int block = 0; block < scriptBlocks / 2; ++block)
+            {
+                for (auto* t : { &reference, &bank })
+                {
+                    if (block == 0)
+                        for (int note : { 24, 40, 48, 55, 60, 72, 84, 96 })
+                            t->synth.noteOn(note, 0.8f, 0);
+
+                    if (motion == 1)
+                        t->changeParameters([&](PluckParameters& q) { q.damp = (block & 1) != 0 ? 0.2f : 0.3f; });
+                    else if (motion == 2)
+                        t->synth.pitchWheelMoved(1, 8192 + (block % 64 - 32) * 96);
+                }
+
+                a.clear();
+                b.clear();
+                reference.synth.renderNextBlock(a, noMidi, 0, scriptBlockSize);
+                bank.synth.renderNextBlock(b, noMidi, 0, scriptBlockSize);
+
+                diff = juce::jmax(diff, getMaxDifference(a, b));
+
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    for (int i = 0; i < scriptBlockSize; ++i)
+                    {
+                        const double error = a.getSample(ch, i) - b.getSample(ch, i);
+                        errorEnergy += error * error;
+                        signalEnergy += (double) a.getSample(ch, i) * a.getSample(ch, i);
+                    }
+                }
+            }
+
+            const auto what = juce::String(interpolationName(interpolation)) + (stereo ? " stereo " : " mono ") + motionNames[motion];
+
+            if (motion == 2)
+            {
+                const double relativeError = std::sqrt(errorEnergy / juce::jmax(signalEnergy, 1.0e-30));
+                const double tolerance = interpolation == (int) PluckStringDelay::Interpolation::Thiran ? thiranBendTolerance : bendTolerance;
+                checker.report("kernels", what, relativeError <= tolerance, relativeError, "relative error");
+            }
+            else
+            {
+                checker.report("kernels", what, diff <= kernelTolerance, diff);
+            }
+        }
+    }
+
+    //==============================================================================
+    void printDigests()
+    {
+        for (auto engine : { Engine::Reference, Engine::VoiceBank })
+        for (int interpolation = 0; interpolation < 3; ++interpolation)
+        for (bool stereo : { false, true })
+        {
+            PluckParameters p;
+            p.stringInterpolation = interpolation;
+            p.stereoEnabled = stereo;
+            p.stereoMicrotuneCents = 2.0f;
+            p.decay = 2.0f;
+
+            Script script;
+            script.glides = true;
+
+            TestSynth t(engine, p);
+            const auto output = renderScript(t, script);
+
+            std::cout << engineName(engine) << " " << interpolationName(interpolation) << " "
+                      << (stereo ? "stereo" : "mono") << " " << std::hex << std::setw(16) << std::setfill('0')
+                      << getDigest(output) << std::dec << std::setfill(' ') << std::endl;
+        }
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--digests"))
+    {
+        printDigests();
+        return 0;
+    }
+
+    struct Check
+    {
+        const char* name;
+        void (*run) (Checker&);
+    };
+
+    const Check checks[] = {
+        { "spans", checkSpans },
+        { "mono", checkMono },
+        { "midi_queue", checkMidiQueue },
+        { "kernels", checkKernels }
+    };
+
+    const auto only = args.containsOption("--only") ? args.getValueForOption("--only") : juce::String();
+
+    Checker checker;
+
+    for (const auto& check : checks)
+        if (only.isEmpty() || only == check.name)
+            check.run(checker);
+
+    if (checker.failures > 0)
+    {
+        std::cout << checker.failures << " failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,222 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+
+    Renders a MIDI file through a PlucksAudioProcessor without a host or an
+    editor. Setting up (state, MIDI) happens on the calling thread, render()
+    can then run on any thread. Shared by the PlucksRender CLI and the
+    benchmarks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+struct OfflineRenderJob
+{
+    juce::File midiFile;
+    juce::File stateFile;           // optional: plugin state blob or parameter XML
+    juce::File outputFile;          // optional: no WAV is written if empty
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    double tailSeconds = 3.0;       // keep rendering after the last MIDI event
+    PluckSynth::Engine engine = PluckSynth::Engine::VoiceBank;
+    juce::uint32 seed = 0;          // exciter noise seed, 0 keeps the one from the state (if any)
+    PluckStringDelay::Interpolation interpolation = PluckStringDelay::Interpolation::Lagrange3rd;
+    float silenceFloorDb = -80.0f;  // voices end below this level
+    bool noteTimer = false;         // end voices on the old length heuristic instead
+    int renderThreads = 0;          // voice render threads inside the plugin, on top of the job's own
+};
+
+struct OfflineRenderResult
+{
+    juce::Result result = juce::Result::ok();
+    juce::int64 numSamples = 0;
+    double renderSeconds = 0.0;     // processBlock time only, no file IO
+
+    double getSamplesPerSecond() const { return renderSeconds > 0.0 ? (double) numSamples / renderSeconds : 0.0; }
+};
+
+class OfflineRenderer
+{
+public:
+    explicit OfflineRenderer(const OfflineRenderJob& jobToRender)
+        : job(jobToRender)
+    {
+    }
+
+    const OfflineRenderJob& getJob() const { return job; }
+    PlucksAudioProcessor& getProcessor() { return processor; }
+
+    // Loads MIDI and state. Call this on the main thread, the APVTS wants that.
+    juce::Result prepare()
+    {
+        if (job.sampleRate <= 0.0 || job.blockSize <= 0)
+            return juce::Result::fail("invalid sample rate or block size");
+
+        auto midiResult = loadMidi();
+        if (midiResult.failed())
+            return midiResult;
+
+        if (job.stateFile != juce::File())
+        {
+            auto stateResult = loadState();
+            if (stateResult.failed())
+                return stateResult;
+        }
+
+        processor.setNonRealtime(true);
+        processor.setPlayConfigDetails(0, 2, job.sampleRate, job.blockSize);
+        processor.setRenderEngine(job.engine);
+        processor.setStringInterpolation(job.interpolation);
+        processor.setSilenceFloorDb(job.silenceFloorDb);
+        processor.setNoteTimerEnabled(job.noteTimer);
+        processor.setRenderThreads(job.renderThreads);
+
+        if (job.seed != 0)
+            processor.setNoiseSeed(job.seed);
+
+        processor.prepareToPlay(job.sampleRate, job.blockSize);
+
+        totalSamples = (juce::int64) std::ceil((sequence.getEndTime() + job.tailSeconds) * job.sampleRate);
+        isPrepared = true;
+        return juce::Result::ok();
+    }
+
+    // Renders the whole file into 'output' (stereo). Safe to call off the main thread.
+    OfflineRenderResult render(juce::AudioBuffer<float>& output)
+    {
+        OfflineRenderResult r;
+
+        if (! isPrepared)
+        {
+            r.result = juce::Result::fail("render() called before prepare()");
+            return r;
+        }
+
+        output.setSize(2, (int) totalSamples);
+        output.clear();
+
+        juce::AudioBuffer<float> block(2, job.blockSize);
+        juce::MidiBuffer midi;
+        int nextEvent = 0;
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (juce::int64 pos = 0; pos < totalSamples; pos += job.blockSize)
+        {
+            const int numSamples = (int) juce::jmin((juce::int64) job.blockSize, totalSamples - pos);
+            const double blockEnd = (double) (pos + numSamples) / job.sampleRate;
+
+            midi.clear();
+
+            while (nextEvent < sequence.getNumEvents())
+            {
+                const auto& message = sequence.getEventPointer(nextEvent)->message;
+                if (message.getTimeStamp() >= blockEnd)
+                    break;
+
+                const int offset = juce::jlimit(0, numSamples - 1,
+                                                (int) (message.getTimeStamp() * job.sampleRate - (double) pos));
+                midi.addEvent(message, offset);
+                ++nextEvent;
+            }
+
+            block.setSize(2, numSamples, false, false, true);
+            block.clear();
+            processor.processBlock(block, midi);
+
+            for (int ch = 0; ch < 2; ++ch)
+                output.copyFrom(ch, (int) pos, block, ch, 0, numSamples);
+        }
+
+        r.renderSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        r.numSamples = totalSamples;
+        return r;
+    }
+
+    // Renders and writes job.outputFile as 24 bit WAV.
+    OfflineRenderResult renderToFile()
+    {
+        juce::AudioBuffer<float> output;
+        auto r = render(output);
+
+        if (r.result.wasOk() && job.outputFile != juce::File())
+            r.result = writeWav(output);
+
+        return r;
+    }
+
+private:
+    juce::Result loadMidi()
+    {
+        juce::FileInputStream in(job.midiFile);
+        if (! in.openedOk())
+            return juce::Result::fail("can't open MIDI file " + job.midiFile.getFullPathName());
+
+        juce::MidiFile midiFile;
+        if (! midiFile.readFrom(in))
+            return juce::Result::fail("not a valid MIDI file: " + job.midiFile.getFullPathName());
+
+        midiFile.convertTimestampTicksToSeconds();
+
+        // flatten every track, the synth doesn't care about channels
+        for (int t = 0; t < midiFile.getNumTracks(); ++t)
+            sequence.addSequence(*midiFile.getTrack(t), 0.0);
+
+        sequence.updateMatchedPairs();
+        return juce::Result::ok();
+    }
+
+    juce::Result loadState()
+    {
+        juce::MemoryBlock data;
+
+        if (job.stateFile.hasFileExtension("xml"))
+        {
+            // plain parameter XML, the format getStateInformation() wrote before PluckState
+            auto xml = juce::XmlDocument::parse(job.stateFile);
+            if (xml == nullptr)
+                return juce::Result::fail("can't parse state XML " + job.stateFile.getFullPathName());
+
+            juce::AudioProcessor::copyXmlToBinary(*xml, data);
+        }
+        else if (! job.stateFile.loadFileAsData(data))
+        {
+            return juce::Result::fail("can't read state file " + job.stateFile.getFullPathName());
+        }
+
+        processor.setStateInformation(data.getData(), (int) data.getSize());
+        return juce::Result::ok();
+    }
+
+    juce::Result writeWav(const juce::AudioBuffer<float>& output)
+    {
+        job.outputFile.deleteFile();
+        auto stream = job.outputFile.createOutputStream();
+
+        if (stream == nullptr)
+            return juce::Result::fail("can't write " + job.outputFile.getFullPathName());
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), job.sampleRate,
+                                                                            (unsigned int) output.getNumChannels(),
+                                                                            24, {}, 0));
+        if (writer == nullptr)
+            return juce::Result::fail("can't create WAV writer for " + job.outputFile.getFullPathName());
+
+        stream.release(); // the writer owns it now
+        writer->writeFromAudioSampleBuffer(output, 0, output.getNumSamples());
+        return juce::Result::ok();
+    }
+
+    OfflineRenderJob job;
+    PlucksAudioProcessor processor;
+    juce::MidiMessageSequence sequence;
+    juce::int64 totalSamples = 0;
+    bool isPrepared = false;
+};
@@ -0,0 +1,249 @@
+/*
+  ==============================================================================
+
+    RenderMain.cpp
+
+    PlucksRender: bounce MIDI files through Plucks without a DAW.
+
+      PlucksRender --midi=in.mid --out=out.wav [--state=preset.xml]
+                   [--rate=48000] [--block=512] [--tail=3] [--engine=bank|reference] [--seed=N]
+                   [--interp=lagrange|thiran|linear] [--floor=-80] [--note-timer]
+                   [--render-threads=N]
+
+      PlucksRender --jobs=jobs.txt [--threads=N]
+
+    With a seed (from --seed or saved in the state) the output is the same
+    bit for bit on every run.
+
+    A jobs file has one render per line, using the same options as above.
+    Empty lines and lines starting with # are skipped. Jobs are spread over
+    all cores unless --threads says otherwise.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    juce::Result parseJob(const juce::ArgumentList& args, OfflineRenderJob& job)
+    {
+        if (! args.containsOption("--midi"))
+            return juce::Result::fail("missing --midi=<file>");
+
+        job.midiFile = args.getExistingFileForOption("--midi");
+
+        if (args.containsOption("--state"))
+            job.stateFile = args.getExistingFileForOption("--state");
+
+        if (args.containsOption("--out"))
+            job.outputFile = args.getFileForOption("--out");
+
+        if (args.containsOption("--rate"))
+            job.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+
+        if (args.containsOption("--block"))
+            job.blockSize = args.getValueForOption("--block").getIntValue();
+
+        if (args.containsOption("--tail"))
+            job.tailSeconds = args.getValueForOption("--tail").getDoubleValue();
+
+        if (args.containsOption("--engine"))
+        {
+            auto engine = args.getValueForOption("--engine");
+
+            if (engine == "reference")
+                job.engine = PluckSynth::Engine::Reference;
+            else if (engine == "bank")
+                job.engine = PluckSynth::Engine::VoiceBank;
+            else
+                return juce::Result::fail("unknown --engine " + engine + " (use bank or reference)");
+        }
+
+        if (args.containsOption("--interp"))
+        {
+            auto interp = args.getValueForOption("--interp");
+
+            if (interp == "lagrange")
+                job.interpolation = PluckStringDelay::Interpolation::Lagrange3rd;
+            else if (interp == "thiran")
+                job.interpolation = PluckStringDelay::Interpolation::Thiran;
+            else if (interp == "linear")
+                job.interpolation = PluckStringDelay::Interpolation::Linear;
+            else
+                return juce::Result::fail("unknown --interp " + interp + " (use lagrange, thiran or linear)");
+        }
+
+        if (args.containsOption("--seed"))
+            job.seed = static_cast<juce::uint32>(args.getValueForOption("--seed").getLargeIntValue());
+
+        if (args.containsOption("--floor"))
+            job.silenceFloorDb = args.getValueForOption("--floor").getFloatValue();
+
+        job.noteTimer = args.containsOption("--note-timer");
+
+        if (args.containsOption("--render-threads"))
+            job.renderThreads = args.getValueForOption("--render-threads").getIntValue();
+
+        return juce::Result::ok();
+    }
+
+    juce::Array<OfflineRenderJob> readJobsFile(const juce::File& jobsFile, const juce::String& executable)
+    {
+        juce::Array<OfflineRenderJob> jobs;
+        juce::StringArray lines;
+        jobsFile.readLines(lines);
+
+        // relative paths in the jobs file are relative to the jobs file
+        jobsFile.getParentDirectory().setAsCurrentWorkingDirectory();
+
+        for (int i = 0; i < lines.size(); ++i)
+        {
+            auto line = lines[i].trim();
+            if (line.isEmpty() || line.startsWith("#"))
+                continue;
+
+            juce::ArgumentList args(executable, juce::StringArray::fromTokens(line, true));
+
+            OfflineRenderJob job;
+            auto result = parseJob(args, job);
+
+            if (result.failed())
+                juce::ConsoleApplication::fail(jobsFile.getFileName() + " line " + juce::String(i + 1) + ": "
+                                               + result.getErrorMessage());
+
+            jobs.add(job);
+        }
+
+        return jobs;
+    }
+
+    void printResult(const OfflineRenderJob& job, const OfflineRenderResult& r)
+    {
+        const double seconds = (double) r.numSamples / job.sampleRate;
+
+        std::cout << job.midiFile.getFileName() << " -> "
+                  << (job.outputFile == juce::File() ? juce::String("(no output)") : job.outputFile.getFileName())
+                  << ": " << r.numSamples << " samples in " << juce::String(r.renderSeconds, 3) << " s, "
+                  << juce::String(r.getSamplesPerSecond() / 1.0e6, 2) << " M samples/s, "
+                  << juce::String(r.renderSeconds > 0.0 ? seconds / r.renderSeconds : 0.0, 1) << "x realtime"
+                  << std::endl;
+    }
+
+    int runJobs(const juce::Array<OfflineRenderJob>& jobs, int numThreads)
+    {
+        // processors are set up here on the main thread, only the rendering is spread out
+        std::vector<std::unique_ptr<OfflineRenderer>> renderers;
+
+        for (const auto& job : jobs)
+        {
+            auto renderer = std::make_unique<OfflineRenderer>(job);
+            auto result = renderer->prepare();
+
+            if (result.failed())
+                juce::ConsoleApplication::fail(job.midiFile.getFileName() + ": " + result.getErrorMessage());
+
+            renderers.push_back(std::move(renderer));
+        }
+
+        std::vector<OfflineRenderResult> results(renderers.size());
+        std::atomic<size_t> nextJob { 0 };
+
+        auto worker = [&]
+        {
+            for (size_t i = nextJob++; i < renderers.size(); i = nextJob++)
+                results[i] = renderers[i]->renderToFile();
+        };
+
+        numThreads = juce::jlimit(1, (int) renderers.size(), numThreads);
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        std::vector<std::thread> threads;
+        for (int t = 1; t < numThreads; ++t)
+            threads.emplace_back(worker);
+
+        worker();
+
+        for (auto& t : threads)
+            t.join();
+
+        const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        int failures = 0;
+        juce::int64 totalSamples = 0;
+
+        for (size_t i = 0; i < renderers.size(); ++i)
+        {
+            if (results[i].result.failed())
+            {
+                std::cerr << renderers[i]->getJob().midiFile.getFileName() << ": "
+                          << results[i].result.getErrorMessage() << std::endl;
+                ++failures;
+                continue;
+            }
+
+            printResult(renderers[i]->getJob(), results[i]);
+            totalSamples += results[i].numSamples;
+        }
+
+        if (renderers.size() > 1)
+            std::cout << renderers.size() << " jobs on " << numThreads << " threads: "
+                      << totalSamples << " samples in " << juce::String(wallSeconds, 3) << " s, "
+                      << juce::String(wallSeconds > 0.0 ? (double) totalSamples / wallSeconds / 1.0e6 : 0.0, 2)
+                      << " M samples/s" << std::endl;
+
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit; // APVTS needs a message manager
+
+    juce::ArgumentList args(argc, argv);
+
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        std::cout << "usage: PlucksRender --midi=in.mid --out=out.wav [--state=state.xml|state.bin]" << std::endl
+                  << "                    [--rate=48000] [--block=512] [--tail=3] [--engine=bank|reference] [--seed=N]" << std::endl
+                  << "                    [--interp=lagrange|thiran|linear] [--floor=-80] [--note-timer]" << std::endl
+                  << "                    [--render-threads=N]" << std::endl
+                  << "       PlucksRender --jobs=jobs.txt [--threads=N]" << std::endl;
+        return 0;
+    }
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&]
+    {
+        juce::Array<OfflineRenderJob> jobs;
+        int numThreads = 1;
+
+        if (args.containsOption("--jobs"))
+        {
+            jobs = readJobsFile(args.getExistingFileForOption("--jobs"), args.executableName);
+            numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                          : juce::SystemStats::getNumCpus();
+        }
+        else
+        {
+            OfflineRenderJob job;
+            auto result = parseJob(args, job);
+
+            if (result.failed())
+                juce::ConsoleApplication::fail(result.getErrorMessage());
+
+            jobs.add(job);
+        }
+
+        if (jobs.size() == 0)
+            juce::ConsoleApplication::fail("nothing to render");
+
+        return runJobs(jobs, numThreads);
+    });
+}